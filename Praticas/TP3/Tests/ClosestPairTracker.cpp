@@ -0,0 +1,159 @@
+/*
+ * ClosestPairTracker.cpp
+ */
+
+#include <cmath>
+#include <limits>
+#include "ClosestPairTracker.h"
+
+/*
+ * Adds a point, and returns its id (ids are given in order, from 0).
+ * O(log^2 n) amortized time.
+ */
+int ClosestPairTracker::insert(const Point &p) {
+	int id = points.size();
+	points.push_back(p);
+	present.push_back(1);
+	levelOf.push_back(-1);
+	slotOf.push_back(-1);
+	neighbour.push_back(-1);
+	chosenBy.push_back(vector<int>());
+	numPresent++;
+	chooseNeighbour(id);
+	addToLevels(id);
+	return id;
+}
+
+/*
+ * Removes the point with the given id. Returns false if there is no such
+ * point (or it was already erased).
+ * The points that had it as neighbour choose a new one: O(log^2 n) time each.
+ */
+bool ClosestPairTracker::erase(int id) {
+	if (id < 0 || id >= (int) points.size() || !present[id])
+		return false;
+	present[id] = 0;
+	numPresent--;
+	levels[levelOf[id]].tree->erase(slotOf[id]);
+	numErased++;
+	dropNeighbour(id);
+
+	vector<int> orphans;
+	for (int p : chosenBy[id])
+		if (present[p] && neighbour[p] == id) {
+			dropNeighbour(p);
+			orphans.push_back(p);
+		}
+	vector<int>().swap(chosenBy[id]);
+	for (int p : orphans)
+		chooseNeighbour(p);
+
+	if (numErased > numPresent)
+		rebuild();
+	return true;
+}
+
+int ClosestPairTracker::size() const {
+	return numPresent;
+}
+
+/*
+ * Returns the closest pair of the current points (with dmin the maximum
+ * double if there are less than two). O(1) time.
+ */
+Result ClosestPairTracker::getResult() const {
+	if (candidates.empty())
+		return Result();
+	auto &best = *candidates.begin();
+	return Result(sqrt(best.first), points[best.second], points[neighbour[best.second]]);
+}
+
+/*
+ * Sets the neighbour of point id to the nearest other current point.
+ */
+void ClosestPairTracker::chooseNeighbour(int id) {
+	int best = -1;
+	double minSquare = numeric_limits<double>::infinity();
+	for (auto &level : levels) {
+		if (!level.tree)
+			continue;
+		// the 2 nearest, as id itself may be in the tree
+		for (int i : level.tree->nearestK(points[id], 2)) {
+			int other = level.members[i];
+			if (other == id)
+				continue;
+			double d = points[id].distSquare(points[other]);
+			if (d < minSquare) {
+				minSquare = d;
+				best = other;
+			}
+			break;
+		}
+	}
+	neighbour[id] = best;
+	if (best != -1) {
+		candidates.insert(make_pair(minSquare, id));
+		chosenBy[best].push_back(id);
+	}
+}
+
+void ClosestPairTracker::dropNeighbour(int id) {
+	if (neighbour[id] == -1)
+		return;
+	candidates.erase(make_pair(points[id].distSquare(points[neighbour[id]]), id));
+	neighbour[id] = -1;
+}
+
+/*
+ * Puts point id, and the current points of the lower levels, in a new tree,
+ * in the first empty level.
+ */
+void ClosestPairTracker::addToLevels(int id) {
+	vector<int> members(1, id);
+	unsigned k = 0;
+	for (; k < levels.size() && levels[k].tree; k++) {
+		for (int p : levels[k].members)
+			if (present[p])
+				members.push_back(p);
+			else
+				numErased--;
+		levels[k].tree.reset();
+		levels[k].members.clear();
+	}
+	if (k == levels.size())
+		levels.push_back(Level());
+	vector<Point> vp;
+	for (unsigned i = 0; i < members.size(); i++) {
+		vp.push_back(points[members[i]]);
+		levelOf[members[i]] = k;
+		slotOf[members[i]] = i;
+	}
+	levels[k].tree.reset(new KdTree(vp));
+	levels[k].members = members;
+}
+
+/*
+ * Puts all the current points in a single tree, in the top level.
+ */
+void ClosestPairTracker::rebuild() {
+	vector<int> members;
+	for (auto &level : levels) {
+		for (int p : level.members)
+			if (present[p])
+				members.push_back(p);
+		level.tree.reset();
+		level.members.clear();
+	}
+	numErased = 0;
+	if (members.empty())
+		return;
+	Level &top = levels.back();
+	vector<Point> vp;
+	for (unsigned i = 0; i < members.size(); i++) {
+		vp.push_back(points[members[i]]);
+		levelOf[members[i]] = levels.size() - 1;
+		slotOf[members[i]] = i;
+	}
+	top.tree.reset(new KdTree(vp));
+	top.members = members;
+}
@@ -0,0 +1,58 @@
+/*
+ * ClosestPairTracker.h
+ * Closest pair of a set of points that changes over time (points are
+ * inserted and erased), kept up to date after each change.
+ */
+
+#ifndef CLOSESTPAIRTRACKER_H_
+#define CLOSESTPAIRTRACKER_H_
+
+#include <vector>
+#include <set>
+#include <memory>
+#include "Point.h"
+#include "NearestPoints.h"
+#include "KdTree.h"
+
+using namespace std;
+
+/*
+ * Each point keeps a neighbour: the point nearest to it when it was
+ * inserted, or when its previous neighbour was erased. Its neighbour may not
+ * be the nearest any more, but the closest pair is always the point with the
+ * nearest neighbour and that neighbour (of the two points of the closest
+ * pair, the one whose neighbour was chosen last chose among both).
+ *
+ * Nearest points are found in k-d trees: the points are split into levels,
+ * each with a static KdTree, and an insertion merges the lower levels into
+ * the first empty one (as a binary counter), so each point is moved
+ * O(log n) times. Erased points are removed from their trees, and all the
+ * trees are rebuilt when there are more erased points than points.
+ */
+class ClosestPairTracker {
+	struct Level {
+		unique_ptr<KdTree> tree;
+		vector<int> members;   // id of each point of the tree
+	};
+	vector<Level> levels;
+	vector<Point> points;          // by id
+	vector<char> present;
+	vector<int> levelOf, slotOf;   // level of each point, and its index in the tree
+	vector<int> neighbour;         // -1 if none
+	vector<vector<int>> chosenBy;  // points that chose each point as neighbour (some may not any more)
+	set<pair<double, int>> candidates;  // (squared distance to its neighbour, id), by point
+	int numPresent = 0;
+	int numErased = 0;             // erased points still in the trees
+
+	void chooseNeighbour(int id);
+	void dropNeighbour(int id);
+	void addToLevels(int id);
+	void rebuild();
+public:
+	int insert(const Point &p);
+	bool erase(int id);
+	int size() const;
+	Result getResult() const;
+};
+
+#endif /* CLOSESTPAIRTRACKER_H_ */
@@ -0,0 +1,178 @@
+/*
+ * DistanceKernels.h
+ * Search of the point nearest to a given one among points stored as arrays
+ * of x and y coordinates, by squared distance, for coordinates of type
+ * double, float or int32_t, with SIMD instructions where available
+ * (SSE2 or AVX for double and float, SSE2 or AVX2 for int32_t).
+ */
+
+#ifndef DISTANCEKERNELS_H_
+#define DISTANCEKERNELS_H_
+
+#include <cstdint>
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*
+ * Type of squared distances between points with coordinates of type Coord:
+ * the same type, except for int32_t, whose squares need 64 bits.
+ */
+template <class Coord> struct SquareOf {
+	typedef Coord type;
+};
+template <> struct SquareOf<int32_t> {
+	typedef int64_t type;
+};
+
+/*
+ * Examines the points from index j to to-1 one by one, updating minSquare
+ * and best with each one strictly nearer than the nearest so far.
+ */
+template <class Coord>
+inline void nearestSquareScalar(const Coord *xs, const Coord *ys, int &j, int to, Coord x, Coord y,
+		typename SquareOf<Coord>::type &minSquare, int &best) {
+	typedef typename SquareOf<Coord>::type Square;
+	for (; j < to; j++) {
+		Square dx = (Square) xs[j] - x, dy = (Square) ys[j] - y;
+		Square d = dx * dx + dy * dy;
+		if (d < minSquare) {
+			minSquare = d;
+			best = j;
+		}
+	}
+}
+
+/*
+ * Finds, among the points with indices from to to-1, the one nearest to (x, y)
+ * (the lowest index, on ties), if its squared distance is less than minSquare.
+ * Returns its index and sets minSquare to that squared distance, or returns -1
+ * (leaving minSquare unchanged) if no point is that near.
+ * The specializations compute the distances of groups of points at once; the
+ * points of a group are only examined one by one if one of them improves
+ * minSquare.
+ */
+template <class Coord>
+inline int nearestSquare(const Coord *xs, const Coord *ys, int from, int to, Coord x, Coord y,
+		typename SquareOf<Coord>::type &minSquare) {
+	int best = -1, j = from;
+	nearestSquareScalar(xs, ys, j, to, x, y, minSquare, best);
+	return best;
+}
+
+/*
+ * double: 4 points at a time (AVX) or 2 (SSE2).
+ */
+template <>
+inline int nearestSquare<double>(const double *xs, const double *ys, int from, int to, double x, double y, double &minSquare) {
+	int best = -1, j = from;
+#if defined(__AVX__)
+	__m256d px = _mm256_set1_pd(x), py = _mm256_set1_pd(y);
+	while (j + 4 <= to) {
+		__m256d dx = _mm256_sub_pd(_mm256_loadu_pd(xs + j), px);
+		__m256d dy = _mm256_sub_pd(_mm256_loadu_pd(ys + j), py);
+		__m256d d = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+		if (_mm256_movemask_pd(_mm256_cmp_pd(d, _mm256_set1_pd(minSquare), _CMP_LT_OQ)))
+			nearestSquareScalar(xs, ys, j, j + 4, x, y, minSquare, best);
+		else
+			j += 4;
+	}
+#elif defined(__SSE2__)
+	__m128d px = _mm_set1_pd(x), py = _mm_set1_pd(y);
+	while (j + 2 <= to) {
+		__m128d dx = _mm_sub_pd(_mm_loadu_pd(xs + j), px);
+		__m128d dy = _mm_sub_pd(_mm_loadu_pd(ys + j), py);
+		__m128d d = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+		if (_mm_movemask_pd(_mm_cmplt_pd(d, _mm_set1_pd(minSquare))))
+			nearestSquareScalar(xs, ys, j, j + 2, x, y, minSquare, best);
+		else
+			j += 2;
+	}
+#endif
+	nearestSquareScalar(xs, ys, j, to, x, y, minSquare, best);
+	return best;
+}
+
+/*
+ * float: 8 points at a time (AVX) or 4 (SSE2).
+ */
+template <>
+inline int nearestSquare<float>(const float *xs, const float *ys, int from, int to, float x, float y, float &minSquare) {
+	int best = -1, j = from;
+#if defined(__AVX__)
+	__m256 px = _mm256_set1_ps(x), py = _mm256_set1_ps(y);
+	while (j + 8 <= to) {
+		__m256 dx = _mm256_sub_ps(_mm256_loadu_ps(xs + j), px);
+		__m256 dy = _mm256_sub_ps(_mm256_loadu_ps(ys + j), py);
+		__m256 d = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+		if (_mm256_movemask_ps(_mm256_cmp_ps(d, _mm256_set1_ps(minSquare), _CMP_LT_OQ)))
+			nearestSquareScalar(xs, ys, j, j + 8, x, y, minSquare, best);
+		else
+			j += 8;
+	}
+#elif defined(__SSE2__)
+	__m128 px = _mm_set1_ps(x), py = _mm_set1_ps(y);
+	while (j + 4 <= to) {
+		__m128 dx = _mm_sub_ps(_mm_loadu_ps(xs + j), px);
+		__m128 dy = _mm_sub_ps(_mm_loadu_ps(ys + j), py);
+		__m128 d = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+		if (_mm_movemask_ps(_mm_cmplt_ps(d, _mm_set1_ps(minSquare))))
+			nearestSquareScalar(xs, ys, j, j + 4, x, y, minSquare, best);
+		else
+			j += 4;
+	}
+#endif
+	nearestSquareScalar(xs, ys, j, to, x, y, minSquare, best);
+	return best;
+}
+
+/*
+ * int32_t: 8 points at a time (AVX2) or 4 (SSE2), with the differences in 32
+ * bits, so coordinates must be in [-2^30, 2^30), and their squares in float.
+ * These are rounded (by less than 2^-21, relative), so they only select the
+ * groups with a point that may be nearer than minSquare: one below it plus a
+ * margin of 2^-20. Those points are then examined exactly, in 64 bits.
+ */
+inline float int32SquareBound(int64_t minSquare) {
+	return (float) minSquare * (1.0f + 1.0f / (1 << 20));
+}
+
+template <>
+inline int nearestSquare<int32_t>(const int32_t *xs, const int32_t *ys, int from, int to, int32_t x, int32_t y, int64_t &minSquare) {
+	int best = -1, j = from;
+#if defined(__AVX2__)
+	__m256i px = _mm256_set1_epi32(x), py = _mm256_set1_epi32(y);
+	__m256 bound = _mm256_set1_ps(int32SquareBound(minSquare));
+	while (j + 8 <= to) {
+		__m256 dx = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_loadu_si256((const __m256i *) (xs + j)), px));
+		__m256 dy = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_loadu_si256((const __m256i *) (ys + j)), py));
+		__m256 d = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+		if (_mm256_movemask_ps(_mm256_cmp_ps(d, bound, _CMP_LT_OQ))) {
+			nearestSquareScalar(xs, ys, j, j + 8, x, y, minSquare, best);
+			bound = _mm256_set1_ps(int32SquareBound(minSquare));
+		}
+		else
+			j += 8;
+	}
+#elif defined(__SSE2__)
+	__m128i px = _mm_set1_epi32(x), py = _mm_set1_epi32(y);
+	__m128 bound = _mm_set1_ps(int32SquareBound(minSquare));
+	while (j + 4 <= to) {
+		__m128 dx = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_loadu_si128((const __m128i *) (xs + j)), px));
+		__m128 dy = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_loadu_si128((const __m128i *) (ys + j)), py));
+		__m128 d = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+		if (_mm_movemask_ps(_mm_cmplt_ps(d, bound))) {
+			nearestSquareScalar(xs, ys, j, j + 4, x, y, minSquare, best);
+			bound = _mm_set1_ps(int32SquareBound(minSquare));
+		}
+		else
+			j += 4;
+	}
+#endif
+	nearestSquareScalar(xs, ys, j, to, x, y, minSquare, best);
+	return best;
+}
+
+#endif /* DISTANCEKERNELS_H_ */
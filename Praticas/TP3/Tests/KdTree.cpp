@@ -0,0 +1,245 @@
+/*
+ * KdTree.cpp
+ */
+
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <cmath>
+#include "KdTree.h"
+
+/*
+ * Ranges with more points than this are built, or scanned by pairsWithin,
+ * in parallel.
+ */
+static const int KD_PARALLEL_CUTOFF = 1 << 14;
+
+/*
+ * Builds the tree with numThreads threads.
+ */
+KdTree::KdTree(const vector<Point> &vp, int numThreads):
+		ids(vp.size()), positions(vp.size()), splitByY(vp.size(), 0), splits(vp.size(), 0) {
+	vector<Point> ordered(vp);
+	for (unsigned i = 0; i < vp.size(); i++)
+		ids[i] = i;
+	TaskPool pool(numThreads);
+	build(pool, ordered, 0, vp.size());
+	points.assign(ordered.begin(), ordered.end());
+	for (unsigned i = 0; i < vp.size(); i++)
+		positions[ids[i]] = i;
+}
+
+/*
+ * Places the node of [left, right) at its middle position (with nth_element),
+ * and builds the subtrees, in parallel if they are large.
+ * vp and ids are reordered together.
+ */
+void KdTree::build(TaskPool &pool, vector<Point> &vp, int left, int right) {
+	if (right - left <= LEAF_SIZE)
+		return;
+	double minX = vp[left].x, maxX = minX, minY = vp[left].y, maxY = minY;
+	for (int i = left + 1; i < right; i++) {
+		minX = min(minX, vp[i].x);
+		maxX = max(maxX, vp[i].x);
+		minY = min(minY, vp[i].y);
+		maxY = max(maxY, vp[i].y);
+	}
+	bool byY = maxY - minY > maxX - minX;
+	int middle = (left + right) / 2;
+
+	// sorts positions, to move each point with its id
+	vector<int> order(right - left);
+	for (int i = left; i < right; i++)
+		order[i - left] = i;
+	nth_element(order.begin(), order.begin() + (middle - left), order.end(), [&vp, byY](int a, int b) {
+		return byY ? vp[a].y < vp[b].y : vp[a].x < vp[b].x;
+	});
+	vector<Point> movedPoints(right - left);
+	vector<int> movedIds(right - left);
+	for (int i = 0; i < right - left; i++) {
+		movedPoints[i] = vp[order[i]];
+		movedIds[i] = ids[order[i]];
+	}
+	copy(movedPoints.begin(), movedPoints.end(), vp.begin() + left);
+	copy(movedIds.begin(), movedIds.end(), ids.begin() + left);
+	splitByY[middle] = byY;
+	splits[middle] = byY ? vp[middle].y : vp[middle].x;
+
+	if (right - left > KD_PARALLEL_CUTOFF) {
+		TaskGroup group(pool);
+		group.run([&] { build(pool, vp, left, middle); });
+		build(pool, vp, middle + 1, right);
+		group.wait();
+	}
+	else {
+		build(pool, vp, left, middle);
+		build(pool, vp, middle + 1, right);
+	}
+}
+
+int KdTree::size() const {
+	return ids.size();
+}
+
+/*
+ * Removes point i (of the vector given) from the results of the queries.
+ * Its coordinates become NaN, so no distance to it is less than another,
+ * and the tree keeps its shape (size() does not change).
+ */
+void KdTree::erase(int i) {
+	double nan = numeric_limits<double>::quiet_NaN();
+	points.setPoint(positions[i], Point(nan, nan));
+}
+
+/*
+ * Nearest point to (x, y) in [left, right), if at squared distance less
+ * than minSquare (updated, with best, if found).
+ */
+void KdTree::nearest(int left, int right, double x, double y, int &best, double &minSquare) const {
+	if (right - left <= LEAF_SIZE) {
+		int i = points.nearest(x, y, left, right, minSquare);
+		if (i != -1)
+			best = i;
+		return;
+	}
+	int middle = (left + right) / 2;
+	double d = (splitByY[middle] ? y : x) - splits[middle];
+	int i = points.nearest(x, y, middle, middle + 1, minSquare);
+	if (i != -1)
+		best = i;
+	// the side of the point first, and the other only if it may be closer
+	if (d < 0)
+		nearest(left, middle, x, y, best, minSquare);
+	else
+		nearest(middle + 1, right, x, y, best, minSquare);
+	if (d * d < minSquare) {
+		if (d < 0)
+			nearest(middle + 1, right, x, y, best, minSquare);
+		else
+			nearest(left, middle, x, y, best, minSquare);
+	}
+}
+
+/*
+ * Returns the point nearest to q (the first one found among equally near
+ * ones), or -1 if the tree is empty.
+ */
+int KdTree::nearest(const Point &q) const {
+	int best = -1;
+	double minSquare = numeric_limits<double>::infinity();
+	nearest(0, size(), q.x, q.y, best, minSquare);
+	return best == -1 ? -1 : ids[best];
+}
+
+/*
+ * Keeps in heap (a max-heap of (squared distance, position)) the k points
+ * of [left, right) and of heap nearest to (x, y).
+ */
+void KdTree::nearestK(int left, int right, double x, double y, unsigned k, vector<pair<double, int>> &heap) const {
+	auto consider = [&](int i) {
+		double d = (points.getX(i) - x) * (points.getX(i) - x) + (points.getY(i) - y) * (points.getY(i) - y);
+		if (std::isnan(d)) // removed
+			return;
+		if (heap.size() < k) {
+			heap.push_back(make_pair(d, i));
+			push_heap(heap.begin(), heap.end());
+		}
+		else if (d < heap.front().first) {
+			pop_heap(heap.begin(), heap.end());
+			heap.back() = make_pair(d, i);
+			push_heap(heap.begin(), heap.end());
+		}
+	};
+	if (right - left <= LEAF_SIZE) {
+		for (int i = left; i < right; i++)
+			consider(i);
+		return;
+	}
+	int middle = (left + right) / 2;
+	double d = (splitByY[middle] ? y : x) - splits[middle];
+	consider(middle);
+	if (d < 0)
+		nearestK(left, middle, x, y, k, heap);
+	else
+		nearestK(middle + 1, right, x, y, k, heap);
+	if (heap.size() < k || d * d < heap.front().first) {
+		if (d < 0)
+			nearestK(middle + 1, right, x, y, k, heap);
+		else
+			nearestK(left, middle, x, y, k, heap);
+	}
+}
+
+/*
+ * Returns the k points nearest to q (all, if there are less than k), from
+ * the nearest to the farthest.
+ */
+vector<int> KdTree::nearestK(const Point &q, int k) const {
+	vector<pair<double, int>> heap;
+	if (k > 0)
+		nearestK(0, size(), q.x, q.y, k, heap);
+	sort_heap(heap.begin(), heap.end());
+	vector<int> res;
+	for (auto &e : heap)
+		res.push_back(ids[e.second]);
+	return res;
+}
+
+/*
+ * Adds to found the positions of the points of [left, right) at squared
+ * distance at most rSquare from (x, y).
+ */
+void KdTree::withinRadius(int left, int right, double x, double y, double rSquare, vector<int> &found) const {
+	auto consider = [&](int i) {
+		if ((points.getX(i) - x) * (points.getX(i) - x) + (points.getY(i) - y) * (points.getY(i) - y) <= rSquare)
+			found.push_back(i);
+	};
+	if (right - left <= LEAF_SIZE) {
+		for (int i = left; i < right; i++)
+			consider(i);
+		return;
+	}
+	int middle = (left + right) / 2;
+	double d = (splitByY[middle] ? y : x) - splits[middle];
+	consider(middle);
+	if (d < 0 || d * d <= rSquare)
+		withinRadius(left, middle, x, y, rSquare, found);
+	if (d >= 0 || d * d <= rSquare)
+		withinRadius(middle + 1, right, x, y, rSquare, found);
+}
+
+/*
+ * Returns the points at distance at most r from q, in no particular order.
+ */
+vector<int> KdTree::withinRadius(const Point &q, double r) const {
+	vector<int> found;
+	withinRadius(0, size(), q.x, q.y, r * r, found);
+	for (int &i : found)
+		i = ids[i];
+	return found;
+}
+
+/*
+ * Returns all the pairs of points at distance at most r, each once, as
+ * (i, j) with i < j, in no particular order. The points are searched from
+ * in parallel, with numThreads threads.
+ */
+vector<pair<int, int>> KdTree::pairsWithin(double r, int numThreads) const {
+	vector<pair<int, int>> pairs;
+	mutex pairsLock;
+	TaskPool pool(numThreads);
+	pool.parallelFor(0, size(), KD_PARALLEL_CUTOFF / 4, [&](int from, int to) {
+		vector<pair<int, int>> part;
+		vector<int> found;
+		for (int i = from; i < to; i++) {
+			found.clear();
+			withinRadius(0, size(), points.getX(i), points.getY(i), r * r, found);
+			for (int j : found)
+				if (ids[i] < ids[j])
+					part.push_back(make_pair(ids[i], ids[j]));
+		}
+		lock_guard<mutex> lock(pairsLock);
+		pairs.insert(pairs.end(), part.begin(), part.end());
+	});
+	return pairs;
+}
@@ -0,0 +1,48 @@
+/*
+ * KdTree.h
+ * Static k-d tree (k = 2) over a set of points, for nearest-neighbour,
+ * k-nearest-neighbours and radius queries.
+ */
+
+#ifndef KDTREE_H_
+#define KDTREE_H_
+
+#include <vector>
+#include <utility>
+#include "Point.h"
+#include "PointSet.h"
+#include "TaskPool.h"
+
+using namespace std;
+
+/*
+ * The points are kept in tree order: the node of a range [left, right) of
+ * positions is the point at its middle position, and its subtrees are the
+ * ranges before and after it, split by x or y (whichever spreads more).
+ * Ranges of up to LEAF_SIZE points are leaves, scanned with PointSet::nearest.
+ * Queries return indices of the points in the vector given to the constructor.
+ * Points can be removed (erase), but not added.
+ */
+class KdTree {
+	static const int LEAF_SIZE = 8;
+	PointSet points;         // in tree order
+	vector<int> ids;         // index of each point in the vector given
+	vector<int> positions;   // position of each point of the vector given
+	vector<char> splitByY;   // at the middle position of each node
+	vector<double> splits;   // coordinate of the split, idem
+
+	void build(TaskPool &pool, vector<Point> &vp, int left, int right);
+	void nearest(int left, int right, double x, double y, int &best, double &minSquare) const;
+	void nearestK(int left, int right, double x, double y, unsigned k, vector<pair<double, int>> &heap) const;
+	void withinRadius(int left, int right, double x, double y, double rSquare, vector<int> &found) const;
+public:
+	KdTree(const vector<Point> &vp, int numThreads = 1);
+	int size() const;
+	void erase(int i);
+	int nearest(const Point &q) const;
+	vector<int> nearestK(const Point &q, int k) const;
+	vector<int> withinRadius(const Point &q, double r) const;
+	vector<pair<int, int>> pairsWithin(double r, int numThreads = 1) const;
+};
+
+#endif /* KDTREE_H_ */
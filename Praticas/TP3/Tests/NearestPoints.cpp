@@ -3,11 +3,17 @@
  */
 
 #include <limits>
-#include <thread>
+#include <memory>
+#include <mutex>
 #include <algorithm>
 #include <cmath>
+#include <random>
+#include <cstdint>
 #include "NearestPoints.h"
 #include "Point.h"
+#include "PointSet.h"
+#include "NearestPointsT.h"
+#include "TaskPool.h"
 
 const double MAX_DOUBLE = std::numeric_limits<double>::max();
 
@@ -28,117 +34,87 @@ Result::Result() {
  */
 static void sortByX(vector<Point> &v, int left, int right)
 {
-	std::sort(v.begin( ) + left, v.begin() + right + 1,
-		[](Point p, Point q){ return p.x < q.x || (p.x == q.x && p.y < q.y); });
+	std::sort(v.begin( ) + left, v.begin() + right + 1, lessXT<double>);
 }
 
 static void sortByY(vector<Point> &v, int left, int right)
 {
-	std::sort(v.begin( ) + left, v.begin() + right + 1,
-		[](Point p, Point q){ return p.y < q.y || (p.y == q.y && p.x < q.x); });
+	std::sort(v.begin( ) + left, v.begin() + right + 1, lessYT<double>);
+}
+
+/**
+ * Converts a result computed with squared distances (see NearestPointsT.h).
+ */
+static Result toResult(const ResultT<double> &res)
+{
+	return Result(res.dmin(), res.p1, res.p2);
+}
+
+/**
+ * Brute force over all the pairs of points, with SIMD instructions
+ * (see nearestPointsT_BF).
+ */
+static Result np_BF(vector<Point> &vp)
+{
+	return toResult(nearestPointsT_BF<double>(vp));
 }
 
 /**
  * Brute force algorithm O(N^2).
  */
 Result nearestPoints_BF(vector<Point> &vp) {
-	Result res;
-
-    for (int i = 0; i < vp.size(); i++) {
-        for (int j = i + 1; j < vp.size(); j++) {
-            if (vp[i].distance(vp[j]) < res.dmin) {
-                res.dmin = vp[i].distance(vp[j]);
-                res.p1 = vp[i];
-                res.p2 = vp[j];
-            }
-        }
-    }
-
-	return res;
+	return np_BF(vp);
 }
 
 /**
  * Improved brute force algorithm, that first sorts points by X axis.
  */
 Result nearestPoints_BF_SortByX(vector<Point> &vp) {
-	Result res;
 	sortByX(vp, 0, vp.size()-1);
-
-    for (int i = 0; i < vp.size(); i++) {
-        for (int j = i + 1; j < vp.size(); j++) {
-            if (vp[i].distance(vp[j]) < res.dmin) {
-                res.dmin = vp[i].distance(vp[j]);
-                res.p1 = vp[i];
-                res.p2 = vp[j];
-            }
-        }
-    }
-
-	return res;
+	return np_BF(vp);
 }
 
-
 /**
  * Auxiliary function to find nearest points in strip, as indicated
  * in the assignment, with points sorted by Y coordinate.
  * The strip is the part of vp between indices left and right (inclusive).
- * "res" contains initially the best solution found so far.
+ * "res" contains initially the best solution found so far, with the
+ * distance squared.
+ * The strip is copied to a PointSet, so that the distances from each point
+ * to the next ones within distance in Y are computed with SIMD instructions.
  */
-static void npByY(vector<Point> &vp, int left, int right, Result &res)
+static void npByY(vector<Point> &vp, int left, int right, ResultT<double> &res)
 {
-    for (int i = left; i <= right; i++) {
-        for (int j = i + 1; j <= right; j++) {
-            if (abs(vp[i].y - vp[j].y) > res.dmin)
-                break;
-            else if (vp[i].distance(vp[j]) < res.dmin) {
-                res.p1 = vp[i];
-                res.p2 = vp[j];
-                res.dmin = vp[i].distance(vp[j]);
-            }
-        }
-    }
+	static thread_local PointSet strip;
+	strip.assign(vp.begin() + left, vp.begin() + right + 1);
+	npInStripT(strip, res);
 }
 
 /**
  * Recursive divide and conquer algorithm.
- * Finds the nearest points in "vp" between indices left and right (inclusive),
- * using at most numThreads.
+ * Finds the nearest points in "vp" between indices left and right (inclusive).
+ * The distance in the result is squared.
  */
-static Result np_DC(vector<Point> &vp, int left, int right, int numThreads) {
-    Result res;
+static ResultT<double> np_DC(vector<Point> &vp, int left, int right) {
+    ResultT<double> res;
 
     // Base case of two points
 	if (right - left == 1) {
-	    res.p1 = vp[left];
-	    res.p2 = vp[right];
-	    res.dmin = vp[left].distance(vp[right]);
+	    res = ResultT<double>(vp[left].distSquare(vp[right]), vp[left], vp[right]);
 	    return res;
 	}
 
 	// Base case of a single point: no solution, so distance is MAX_DOUBLE
-	if (right - left == 0) {
-	    res.dmin = MAX_DOUBLE;
+	if (right - left == 0)
 	    return res;
-	}
 
-	// Divide in halves (left and right) and solve them recursively,
-	// possibly in parallel (in case numThreads > 1)
+	// Divide in halves (left and right) and solve them recursively
     int middle = (left + right) / 2;
-	Result minLeft, minRight;
-	if (numThreads <= 1) {
-        minLeft = np_DC(vp, left, middle, numThreads);
-        minRight = np_DC(vp, middle + 1, right, numThreads);
-    }
-	else {
-	    thread t([&vp, &minLeft, left, middle, numThreads]{
-            minLeft = np_DC(vp, left, middle, numThreads/2);
-	    });
-        minRight = np_DC(vp, middle + 1, right, numThreads/2);
-        t.join();
-	}
+	ResultT<double> minLeft = np_DC(vp, left, middle);
+	ResultT<double> minRight = np_DC(vp, middle + 1, right);
 
 	// Select the best solution from left and right
-	if (minLeft.dmin < minRight.dmin)
+	if (minLeft.dminSquare < minRight.dminSquare)
         res = minLeft;
     else
         res = minRight;
@@ -147,11 +123,11 @@ static Result np_DC(vector<Point> &vp, int left, int right, int numThreads) {
 	int indexLeft = middle;
 	int indexRight = middle;
 
-	while (indexLeft > left && abs(vp[middle].x - vp[indexLeft].x) < res.dmin) {
+	while (indexLeft > left && (vp[middle].x - vp[indexLeft].x) * (vp[middle].x - vp[indexLeft].x) < res.dminSquare) {
 	    indexLeft--;
 	}
 
-    while (indexRight < right && abs(vp[middle].x - vp[indexRight].x) < res.dmin) {
+    while (indexRight < right && (vp[middle].x - vp[indexRight].x) * (vp[middle].x - vp[indexRight].x) < res.dminSquare) {
         indexRight++;
     }
 
@@ -168,10 +144,137 @@ static Result np_DC(vector<Point> &vp, int left, int right, int numThreads) {
 }
 
 
+/**
+ * Subproblems with up to DC_MT_CUTOFF points are solved sequentially by the
+ * multi-threaded algorithm, which splits larger ones in tasks of a TaskPool.
+ */
+static const int DC_MT_CUTOFF = 1 << 13;
+
+/**
+ * Merges a[0..na-1] and b[0..nb-1], sorted by "less", into out: the middle
+ * element of the larger one is placed directly, and the parts before and
+ * after it are merged in parallel.
+ */
+static void parallelMerge(TaskPool &pool, const Point *a, int na, const Point *b, int nb, Point *out,
+		bool (*less)(const Point &, const Point &))
+{
+	if (na + nb <= DC_MT_CUTOFF) {
+		merge(a, a + na, b, b + nb, out, less);
+		return;
+	}
+	int i, j;
+	if (na >= nb) {
+		i = na / 2;
+		j = lower_bound(b, b + nb, a[i], less) - b;
+		out[i + j] = a[i];
+	}
+	else {
+		j = nb / 2;
+		i = upper_bound(a, a + na, b[j], less) - a;
+		out[i + j] = b[j];
+	}
+	int ia = i + (na >= nb), jb = j + (na < nb); // first elements after the middle one
+	TaskGroup group(pool);
+	group.run([&] { parallelMerge(pool, a, i, b, j, out, less); });
+	parallelMerge(pool, a + ia, na - ia, b + jb, nb - jb, out + ia + jb, less);
+	group.wait();
+}
+
+/**
+ * Merge sort of v[0..n-1] by "less", with the halves sorted in parallel,
+ * using aux as temporary.
+ */
+static void parallelSort(TaskPool &pool, Point *v, Point *aux, int n, bool (*less)(const Point &, const Point &))
+{
+	if (n <= DC_MT_CUTOFF) {
+		sort(v, v + n, less);
+		return;
+	}
+	int half = n / 2;
+	TaskGroup group(pool);
+	group.run([&] { parallelSort(pool, v, aux, half, less); });
+	parallelSort(pool, v + half, aux + half, n - half, less);
+	group.wait();
+	parallelMerge(pool, v, half, v + half, n - half, aux, less);
+	pool.parallelFor(0, n, DC_MT_CUTOFF, [&](int from, int to) { copy(aux + from, aux + to, v + from); });
+}
+
+/**
+ * Finds the nearest points in the strip of width res.dminSquare around
+ * middleX, taking its points from byY[left..right] (sorted by Y) in parallel,
+ * and comparing them in parallel (each part from the best solution so far).
+ */
+static void npInStripMT(TaskPool &pool, const vector<Point> &byY, int left, int right, double middleX, ResultT<double> &res)
+{
+	auto inStrip = [&res, middleX](const Point &p) { return (p.x - middleX) * (p.x - middleX) < res.dminSquare; };
+	int parts = (right - left) / DC_MT_CUTOFF + 1;
+	auto partBegin = [=](int k) { return left + (int) ((long) (right - left + 1) * k / parts); };
+
+	// the points of each part that are in the strip are counted, and then copied
+	vector<int> start(parts + 1, 0);
+	pool.parallelFor(0, parts, 1, [&](int from, int to) {
+		for (int k = from; k < to; k++)
+			start[k + 1] = count_if(byY.begin() + partBegin(k), byY.begin() + partBegin(k + 1), inStrip);
+	});
+	for (int k = 0; k < parts; k++)
+		start[k + 1] += start[k];
+	PointSet strip;
+	strip.resize(start[parts]);
+	pool.parallelFor(0, parts, 1, [&](int from, int to) {
+		for (int k = from; k < to; k++) {
+			int i = start[k];
+			for (int p = partBegin(k); p < partBegin(k + 1); p++)
+				if (inStrip(byY[p]))
+					strip.setPoint(i++, byY[p]);
+		}
+	});
+
+	ResultT<double> best = res;
+	mutex bestLock;
+	pool.parallelFor(0, strip.size(), DC_MT_CUTOFF, [&](int from, int to) {
+		ResultT<double> partRes = res;
+		npInStripT(strip, partRes, from, to);
+		lock_guard<mutex> lock(bestLock);
+		if (partRes.dminSquare < best.dminSquare)
+			best = partRes;
+	});
+	res = best;
+}
+
+/**
+ * Multi-threaded version of npT_DC, with the halves solved, and the
+ * merge and the strip computed, by tasks of the pool.
+ */
+static ResultT<double> np_DC_MT(TaskPool &pool, vector<Point> &vp, int left, int right, vector<Point> &byY, vector<Point> &aux) {
+	if (right - left + 1 <= DC_MT_CUTOFF) {
+		static thread_local PointSet strip;
+		return npT_DC(vp, left, right, byY, aux, strip);
+	}
+
+	int middle = (left + right) / 2;
+	double middleX = vp[middle].x;
+	ResultT<double> minLeft, minRight;
+	TaskGroup group(pool);
+	group.run([&] { minLeft = np_DC_MT(pool, vp, left, middle, byY, aux); });
+	minRight = np_DC_MT(pool, vp, middle + 1, right, byY, aux);
+	group.wait();
+	ResultT<double> res = minLeft.dminSquare < minRight.dminSquare ? minLeft : minRight;
+
+	parallelMerge(pool, &byY[left], middle - left + 1, &byY[middle + 1], right - middle, &aux[left], lessYT<double>);
+	pool.parallelFor(left, right + 1, DC_MT_CUTOFF, [&](int from, int to) {
+		copy(aux.begin() + from, aux.begin() + to, byY.begin() + from);
+	});
+	npInStripMT(pool, byY, left, right, middleX, res);
+	return res;
+}
+
 /**
  * Defines the number of threads to be used.
+ * The threads are kept in a pool, reused by the following calls of
+ * nearestPoints_DC_MT.
  */
 static int numThreads = 1;
+static unique_ptr<TaskPool> taskPool;
 void setNumThreads(int num)
 {
 	numThreads = num;
@@ -182,15 +285,154 @@ void setNumThreads(int num)
  */
 Result nearestPoints_DC(vector<Point> &vp) {
 	sortByX(vp, 0, vp.size() -1);
-	return np_DC(vp, 0, vp.size() - 1, 1);
+	return toResult(np_DC(vp, 0, vp.size() - 1));
 }
 
 
 /*
  * Multi-threaded version, using the number of threads specified
- * by setNumThreads().
+ * by setNumThreads(). Based on the merge by Y of nearestPoints_DC_SortedY,
+ * with subproblems, merges and strips split in tasks of a work-stealing
+ * pool of threads (instead of a new thread per split).
  */
 Result nearestPoints_DC_MT(vector<Point> &vp) {
-	sortByX(vp, 0, vp.size() -1);
-	return np_DC(vp, 0, vp.size() - 1, numThreads);
+	if (vp.empty())
+		return Result();
+	if (!taskPool || taskPool->getNumThreads() != max(numThreads, 1))
+		taskPool.reset(new TaskPool(numThreads));
+	vector<Point> byY(vp.size()), aux(vp.size());
+	parallelSort(*taskPool, vp.data(), aux.data(), vp.size(), lessXT<double>);
+	return toResult(np_DC_MT(*taskPool, vp, 0, vp.size() - 1, byY, aux));
+}
+
+
+/*
+ * Divide and conquer approach that merges the points by Y coordinate
+ * during the recursion (O(n log n)), single-threaded.
+ */
+Result nearestPoints_DC_SortedY(vector<Point> &vp) {
+	return toResult(nearestPointsT_DC<double>(vp));
+}
+
+
+/**
+ * Grid of squares with side "side", for the points of a PointSet: a hash
+ * table of the squares (cells) that contain points, each with the list of
+ * its points. Each table entry has a stamp, so the grid is emptied (to
+ * change the side) without clearing the table.
+ */
+class CellGrid {
+	struct Cell {
+		int64_t cx, cy;  // position in the grid
+		int first;       // first point of the cell (the others follow in next)
+		unsigned stamp;  // the cell is in use if stamp is the one of the grid
+	};
+	const PointSet &ps;
+	vector<Cell> table;
+	vector<int> next;
+	unsigned stamp = 0;
+	double side = 1;
+
+	int64_t cellOf(double c) const {
+		return (int64_t) floor(c / side);
+	}
+	unsigned slot(int64_t cx, int64_t cy) const {
+		uint64_t h = (uint64_t) cx * 0x9E3779B97F4A7C15ULL ^ (uint64_t) cy * 0xC2B2AE3D27D4EB4FULL;
+		return (h ^ (h >> 29)) & (table.size() - 1);
+	}
+public:
+	CellGrid(const PointSet &ps): ps(ps), next(ps.size()) {
+		unsigned size = 1;
+		while (size < 2 * (unsigned) ps.size())
+			size *= 2;
+		table.resize(size);
+	}
+
+	/**
+	 * Empties the grid and sets the side of the cells.
+	 */
+	void reset(double side) {
+		this->side = side;
+		stamp++;
+	}
+
+	/**
+	 * Adds point i (of ps) to its cell.
+	 */
+	void insert(int i) {
+		int64_t cx = cellOf(ps.getX(i)), cy = cellOf(ps.getY(i));
+		unsigned s = slot(cx, cy);
+		while (table[s].stamp == stamp && (table[s].cx != cx || table[s].cy != cy))
+			s = (s + 1) & (table.size() - 1);
+		if (table[s].stamp != stamp) {
+			table[s] = {cx, cy, -1, stamp};
+		}
+		next[i] = table[s].first;
+		table[s].first = i;
+	}
+
+	/**
+	 * Finds, among the points in the cell of (x, y) and the 8 around it,
+	 * one at squared distance less than minSquare. Returns it (updating
+	 * minSquare to its distance), or -1 if there is none.
+	 * If minSquare is at most side squared, this is the nearest point.
+	 */
+	int nearest(double x, double y, double &minSquare) const {
+		int best = -1;
+		int64_t cx = cellOf(x), cy = cellOf(y);
+		for (int64_t i = cx - 1; i <= cx + 1; i++)
+			for (int64_t j = cy - 1; j <= cy + 1; j++) {
+				unsigned s = slot(i, j);
+				while (table[s].stamp == stamp && (table[s].cx != i || table[s].cy != j))
+					s = (s + 1) & (table.size() - 1);
+				if (table[s].stamp != stamp)
+					continue;
+				for (int q = table[s].first; q != -1; q = next[q]) {
+					double d = (ps.getX(q) - x) * (ps.getX(q) - x) + (ps.getY(q) - y) * (ps.getY(q) - y);
+					if (d < minSquare) {
+						minSquare = d;
+						best = q;
+					}
+				}
+			}
+		return best;
+	}
+};
+
+/*
+ * Randomized incremental algorithm (Rabin, Khuller and Matias), in expected
+ * O(n) time: the points are taken in random order, and each one is compared
+ * with the points before it in the cells of a grid around it, with cells of
+ * side equal to the minimum distance so far. When that distance decreases,
+ * the grid is rebuilt with the smaller cells, which happens for the i-th
+ * point with probability at most 2/i.
+ */
+Result nearestPoints_Grid(vector<Point> &vp) {
+	if (vp.size() < 2)
+		return Result();
+	static thread_local mt19937 gen(random_device{}());
+	shuffle(vp.begin(), vp.end(), gen);
+	PointSet ps(vp);
+	CellGrid grid(ps);
+
+	ResultT<double> res(vp[0].distSquare(vp[1]), vp[0], vp[1]);
+	if (res.dminSquare == 0) // repeated point: cells of side 0 cannot be built
+		return toResult(res);
+	grid.reset(sqrt(res.dminSquare));
+	grid.insert(0);
+	grid.insert(1);
+	for (int i = 2; i < ps.size(); i++) {
+		int j = grid.nearest(ps.getX(i), ps.getY(i), res.dminSquare);
+		if (j != -1) {
+			res.p1 = vp[j];
+			res.p2 = vp[i];
+			if (res.dminSquare == 0)
+				return toResult(res);
+			grid.reset(sqrt(res.dminSquare));
+			for (int k = 0; k < i; k++)
+				grid.insert(k);
+		}
+		grid.insert(i);
+	}
+	return toResult(res);
 }
@@ -20,6 +20,8 @@ Result nearestPoints_BF(vector<Point> &vp);
 Result nearestPoints_BF_SortByX(vector<Point> &vp);
 Result nearestPoints_DC(vector<Point> &vp);
 Result nearestPoints_DC_MT(vector<Point> &vp);
+Result nearestPoints_DC_SortedY(vector<Point> &vp);
+Result nearestPoints_Grid(vector<Point> &vp);
 void setNumThreads(int num);
 
 // Pointer to function that computes nearest points
@@ -0,0 +1,196 @@
+/*
+ * NearestPointsT.h
+ * Nearest points algorithms (brute force and divide and conquer, merged by Y)
+ * for points with coordinates of type Coord: double (Point, used by
+ * NearestPoints.cpp), float, or int32_t (with exact squared distances, in
+ * int64_t). Smaller coordinates use less memory, and more of them fit in each
+ * SIMD instruction.
+ */
+
+#ifndef NEARESTPOINTST_H_
+#define NEARESTPOINTST_H_
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include "Point.h"
+#include "PointSet.h"
+
+using namespace std;
+
+/*
+ * Whether coordinate c is represented exactly in Coord (for int32_t, it must
+ * also be in [-2^30, 2^30), see nearestSquare).
+ */
+template <class Coord>
+bool representable(double c) {
+	return c >= numeric_limits<Coord>::lowest() && c <= numeric_limits<Coord>::max() && (double) (Coord) c == c;
+}
+
+template <>
+inline bool representable<int32_t>(double c) {
+	return c >= -(1 << 30) && c < (1 << 30) && (double) (int32_t) c == c;
+}
+
+/*
+ * Converts points with double coordinates to res. Returns false, leaving res
+ * empty, if a coordinate is not represented exactly in Coord (e.g. an integer
+ * above 2^24 in float), as rounding could merge or move points.
+ */
+template <class Coord>
+bool convertPoints(const vector<Point> &vp, vector<PointT<Coord>> &res) {
+	res.clear();
+	for (auto &p : vp)
+		if (!representable<Coord>(p.x) || !representable<Coord>(p.y))
+			return false;
+	res.reserve(vp.size());
+	for (auto &p : vp)
+		res.push_back(PointT<Coord>((Coord) p.x, (Coord) p.y));
+	return true;
+}
+
+/*
+ * Solution, with the distance squared (exact, for int32_t; rounded to 24 bits,
+ * for float, so pairs at distances differing by less than that may be
+ * taken for one another).
+ */
+template <class Coord>
+class ResultT {
+public:
+	typedef typename PointOf<Coord>::type PointType;
+	typedef typename SquareOf<Coord>::type Square;
+	Square dminSquare;       // maximum value if there is no solution
+	PointType p1, p2;
+
+	ResultT(): dminSquare(numeric_limits<Square>::max()), p1(0, 0), p2(0, 0) {}
+	ResultT(Square dminSquare, PointType p1, PointType p2): dminSquare(dminSquare), p1(p1), p2(p2) {}
+
+	/*
+	 * Distance between the points, computed in double (as in Result).
+	 */
+	double dmin() const {
+		if (dminSquare == numeric_limits<Square>::max())
+			return numeric_limits<double>::max();
+		double dx = (double) p1.x - p2.x, dy = (double) p1.y - p2.y;
+		return sqrt(dx * dx + dy * dy);
+	}
+};
+
+/*
+ * Brute force algorithm O(N^2): the points are copied to a PointSetT, so that
+ * the distances from each point to the next ones are computed with SIMD
+ * instructions, and compared squared.
+ */
+template <class Coord>
+ResultT<Coord> nearestPointsT_BF(vector<typename PointOf<Coord>::type> &vp) {
+	ResultT<Coord> res;
+	PointSetT<Coord> ps(vp);
+	for (int i = 0; i < ps.size(); i++) {
+		int j = ps.nearest(ps.getX(i), ps.getY(i), i + 1, ps.size(), res.dminSquare);
+		if (j != -1) {
+			res.p1 = vp[i];
+			res.p2 = vp[j];
+		}
+	}
+	return res;
+}
+
+/*
+ * Orders of the points by X and by Y (ties broken by the other coordinate).
+ */
+template <class Coord>
+bool lessXT(const typename PointOf<Coord>::type &p, const typename PointOf<Coord>::type &q) {
+	return p.x < q.x || (p.x == q.x && p.y < q.y);
+}
+
+template <class Coord>
+bool lessYT(const typename PointOf<Coord>::type &p, const typename PointOf<Coord>::type &q) {
+	return p.y < q.y || (p.y == q.y && p.x < q.x);
+}
+
+/*
+ * Finds the nearest points in a strip of points sorted by Y coordinate,
+ * comparing each point with the next ones within distance res.dminSquare
+ * (squared) in Y (only the points from index "from" to "to"-1, if given,
+ * with the next ones). "res" contains initially the best solution so far.
+ */
+template <class Coord>
+void npInStripT(const PointSetT<Coord> &strip, ResultT<Coord> &res, int from = 0, int to = -1) {
+	typedef typename SquareOf<Coord>::type Square;
+	if (to == -1)
+		to = strip.size();
+	for (int i = from; i < to; i++) {
+		Coord y = strip.getY(i);
+		int end = i + 1;
+		while (end < strip.size() && ((Square) strip.getY(end) - y) * ((Square) strip.getY(end) - y) <= res.dminSquare)
+			end++;
+		int j = strip.nearest(strip.getX(i), y, i + 1, end, res.dminSquare);
+		if (j != -1) {
+			res.p1 = strip.getPoint(i);
+			res.p2 = strip.getPoint(j);
+		}
+	}
+}
+
+/*
+ * Divide and conquer algorithm that keeps the points sorted by Y as in merge
+ * sort, instead of sorting each strip: finds the nearest points in "vp"
+ * (sorted by X) between indices left and right (inclusive), and leaves the
+ * same points, sorted by Y, in byY[left..right] (using aux as temporary).
+ * The strip is taken from them in order, so each level is O(n) and the
+ * whole algorithm O(n log n).
+ */
+template <class Coord>
+ResultT<Coord> npT_DC(vector<typename PointOf<Coord>::type> &vp, int left, int right,
+		vector<typename PointOf<Coord>::type> &byY, vector<typename PointOf<Coord>::type> &aux, PointSetT<Coord> &strip) {
+	typedef typename SquareOf<Coord>::type Square;
+	ResultT<Coord> res;
+
+	// Base cases of a single point (no solution) and of two points
+	if (right - left == 0) {
+		byY[left] = vp[left];
+		return res;
+	}
+	if (right - left == 1) {
+		res = ResultT<Coord>(vp[left].distSquare(vp[right]), vp[left], vp[right]);
+		byY[left] = vp[left];
+		byY[right] = vp[right];
+		if (lessYT<Coord>(byY[right], byY[left]))
+			swap(byY[left], byY[right]);
+		return res;
+	}
+
+	// Solve the halves and merge their points by Y
+	int middle = (left + right) / 2;
+	Coord middleX = vp[middle].x;
+	ResultT<Coord> minLeft = npT_DC(vp, left, middle, byY, aux, strip);
+	ResultT<Coord> minRight = npT_DC(vp, middle + 1, right, byY, aux, strip);
+	res = minLeft.dminSquare < minRight.dminSquare ? minLeft : minRight;
+	merge(byY.begin() + left, byY.begin() + middle + 1, byY.begin() + middle + 1, byY.begin() + right + 1,
+		aux.begin() + left, lessYT<Coord>);
+	copy(aux.begin() + left, aux.begin() + right + 1, byY.begin() + left);
+
+	// The strip area around the middle point, already sorted by Y
+	strip.clear();
+	for (int i = left; i <= right; i++)
+		if (((Square) byY[i].x - middleX) * ((Square) byY[i].x - middleX) < res.dminSquare)
+			strip.addPoint(byY[i]);
+	npInStripT(strip, res);
+	return res;
+}
+
+/*
+ * Divide and conquer algorithm O(n log n), merged by Y (see npT_DC).
+ */
+template <class Coord>
+ResultT<Coord> nearestPointsT_DC(vector<typename PointOf<Coord>::type> &vp) {
+	if (vp.empty())
+		return ResultT<Coord>();
+	sort(vp.begin(), vp.end(), lessXT<Coord>);
+	vector<typename PointOf<Coord>::type> byY(vp.size()), aux(vp.size());
+	PointSetT<Coord> strip;
+	return npT_DC(vp, 0, vp.size() - 1, byY, aux, strip);
+}
+
+#endif /* NEARESTPOINTST_H_ */
@@ -27,11 +27,11 @@ Point::Point(int x, int y) {
 	this->y = y;
 }
 
-double Point::distance(Point &p) {
+double Point::distance(const Point &p) const {
 	return sqrt((x-p.x) * (x-p.x)  + (y-p.y) * (y-p.y));
 }
 
-double Point::distSquare(Point &p) {
+double Point::distSquare(const Point &p) const {
 	return (x-p.x) * (x-p.x)  + (y-p.y) * (y-p.y);
 }
 
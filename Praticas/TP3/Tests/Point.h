@@ -18,8 +18,8 @@ public:
 	Point();
 	Point(double x, double y);
 	Point(int x, int y);
-	double distance(Point &p);
-	double distSquare(Point &p); // distance squared
+	double distance(const Point &p) const;
+	double distSquare(const Point &p) const; // distance squared
 	virtual ~Point();
 	bool operator==(const Point &p) const;
 };
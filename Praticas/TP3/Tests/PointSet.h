@@ -0,0 +1,115 @@
+/*
+ * PointSet.h
+ * Points stored as separate arrays of x and y coordinates (structure of
+ * arrays), so that the squared distances from one point to several others
+ * can be computed with SIMD instructions (see DistanceKernels.h), for
+ * coordinates of type double (PointSet, with Point), float or int32_t.
+ */
+
+#ifndef POINTSET_H_
+#define POINTSET_H_
+
+#include <vector>
+#include "Point.h"
+#include "DistanceKernels.h"
+
+using namespace std;
+
+/*
+ * Point with coordinates of type Coord, for float and int32_t (for double,
+ * Point is used, see PointOf).
+ */
+template <class Coord>
+class PointT {
+public:
+	Coord x;
+	Coord y;
+
+	PointT(): x(0), y(0) {}
+	PointT(Coord x, Coord y): x(x), y(y) {}
+	bool operator==(const PointT &p) const {
+		return x == p.x && y == p.y;
+	}
+	typename SquareOf<Coord>::type distSquare(const PointT &p) const {
+		typedef typename SquareOf<Coord>::type Square;
+		Square dx = (Square) x - p.x, dy = (Square) y - p.y;
+		return dx * dx + dy * dy;
+	}
+};
+
+/*
+ * Type of the points with coordinates of type Coord.
+ */
+template <class Coord> struct PointOf {
+	typedef PointT<Coord> type;
+};
+template <> struct PointOf<double> {
+	typedef Point type;
+};
+
+template <class Coord>
+class PointSetT {
+public:
+	typedef typename PointOf<Coord>::type PointType;
+	typedef typename SquareOf<Coord>::type Square;
+
+	PointSetT() {}
+	PointSetT(const vector<PointType> &vp) {
+		assign(vp.begin(), vp.end());
+	}
+
+	/*
+	 * Replaces the contents with the points between first and last.
+	 */
+	void assign(typename vector<PointType>::const_iterator first, typename vector<PointType>::const_iterator last) {
+		clear();
+		for (auto it = first; it != last; it++)
+			addPoint(*it);
+	}
+	void clear() {
+		xs.clear();
+		ys.clear();
+	}
+	void addPoint(const PointType &p) {
+		xs.push_back(p.x);
+		ys.push_back(p.y);
+	}
+	void resize(int n) {
+		xs.resize(n);
+		ys.resize(n);
+	}
+	void setPoint(int i, const PointType &p) {
+		xs[i] = p.x;
+		ys[i] = p.y;
+	}
+	int size() const {
+		return xs.size();
+	}
+	Coord getX(int i) const {
+		return xs[i];
+	}
+	Coord getY(int i) const {
+		return ys[i];
+	}
+	PointType getPoint(int i) const {
+		return PointType(xs[i], ys[i]);
+	}
+
+	/*
+	 * Finds, among the points with indices from to to-1, the one nearest to
+	 * (x, y) (the lowest index, on ties), if its squared distance is less than
+	 * minSquare. Returns its index and sets minSquare to that squared distance,
+	 * or returns -1 if no point is that near.
+	 * See nearestSquare (the distances are computed with SIMD instructions).
+	 */
+	int nearest(Coord x, Coord y, int from, int to, Square &minSquare) const {
+		return nearestSquare(xs.data(), ys.data(), from, to, x, y, minSquare);
+	}
+
+private:
+	vector<Coord> xs, ys;
+};
+
+typedef PointSetT<double> PointSet;
+
+#endif /* POINTSET_H_ */
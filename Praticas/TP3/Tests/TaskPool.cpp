@@ -0,0 +1,134 @@
+/*
+ * TaskPool.cpp
+ */
+
+#include "TaskPool.h"
+
+thread_local TaskPool *TaskPool::currentPool = nullptr;
+thread_local int TaskPool::currentQueue = 0;
+
+/*
+ * Creates a pool for numThreads threads: numThreads-1 new threads, plus the
+ * thread that waits for the tasks (see TaskGroup::wait).
+ */
+TaskPool::TaskPool(int numThreads): queued(0) {
+	if (numThreads < 1)
+		numThreads = 1;
+	for (int i = 0; i < numThreads; i++)
+		queues.push_back(unique_ptr<WorkQueue>(new WorkQueue()));
+	for (int i = 1; i < numThreads; i++)
+		workers.push_back(thread(&TaskPool::work, this, i));
+}
+
+/*
+ * Runs the tasks still queued, and ends the threads.
+ */
+TaskPool::~TaskPool() {
+	{
+		lock_guard<mutex> lock(sleepLock);
+		stopping = true;
+	}
+	wakeUp.notify_all();
+	for (auto &t : workers)
+		t.join();
+}
+
+int TaskPool::getNumThreads() const {
+	return queues.size();
+}
+
+int TaskPool::queueIndex() const {
+	return currentPool == this ? currentQueue : 0;
+}
+
+/*
+ * Adds a task to the queue of the calling thread.
+ */
+void TaskPool::submit(function<void()> task) {
+	WorkQueue &q = *queues[queueIndex()];
+	{
+		lock_guard<mutex> lock(q.lock);
+		q.tasks.push_back(move(task));
+	}
+	queued++;
+	{
+		lock_guard<mutex> lock(sleepLock); // a thread about to sleep sees queued first
+	}
+	wakeUp.notify_one();
+}
+
+/*
+ * Runs the newest task of queue self or, if there is none, the oldest task
+ * of another queue. Returns false if all the queues are empty.
+ */
+bool TaskPool::runOne(int self) {
+	function<void()> task;
+	int n = queues.size();
+	for (int k = 0; k < n && !task; k++) {
+		WorkQueue &q = *queues[(self + k) % n];
+		lock_guard<mutex> lock(q.lock);
+		if (q.tasks.empty())
+			continue;
+		if (k == 0) {
+			task = move(q.tasks.back());
+			q.tasks.pop_back();
+		}
+		else {
+			task = move(q.tasks.front());
+			q.tasks.pop_front();
+		}
+	}
+	if (!task)
+		return false;
+	queued--;
+	task();
+	return true;
+}
+
+/*
+ * Main loop of the thread with queue self.
+ */
+void TaskPool::work(int self) {
+	currentPool = this;
+	currentQueue = self;
+	while (true) {
+		if (runOne(self))
+			continue;
+		unique_lock<mutex> lock(sleepLock);
+		wakeUp.wait(lock, [this] { return stopping || queued > 0; });
+		if (stopping && queued == 0)
+			return;
+	}
+}
+
+/*
+ * Runs tasks of the pool until pending reaches 0.
+ */
+void TaskPool::runUntil(const atomic<int> &pending) {
+	int self = queueIndex();
+	while (pending > 0)
+		if (!runOne(self))
+			this_thread::yield();
+}
+
+TaskGroup::TaskGroup(TaskPool &pool): pool(pool), pending(0) {
+}
+
+TaskGroup::~TaskGroup() {
+	wait();
+}
+
+void TaskGroup::run(function<void()> task) {
+	pending++;
+	pool.submit([this, task] {
+		task();
+		pending--;
+	});
+}
+
+/*
+ * Waits for all the tasks started with run, running tasks of the pool.
+ */
+void TaskGroup::wait() {
+	pool.runUntil(pending);
+}
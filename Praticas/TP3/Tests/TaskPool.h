@@ -0,0 +1,85 @@
+/*
+ * TaskPool.h
+ * Fixed set of threads that run tasks, with work stealing: each thread keeps
+ * its own queue of tasks, takes the most recent one from it and, when it is
+ * empty, steals the oldest task of another thread.
+ */
+
+#ifndef TASKPOOL_H_
+#define TASKPOOL_H_
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+using namespace std;
+
+class TaskPool {
+	struct WorkQueue {
+		mutex lock;
+		deque<function<void()>> tasks;
+	};
+	vector<unique_ptr<WorkQueue>> queues;  // queue 0 is used by threads outside the pool
+	vector<thread> workers;
+	atomic<int> queued;
+	mutex sleepLock;
+	condition_variable wakeUp;
+	bool stopping = false;
+
+	static thread_local TaskPool *currentPool;
+	static thread_local int currentQueue;
+
+	int queueIndex() const;
+	bool runOne(int self);
+	void work(int self);
+public:
+	explicit TaskPool(int numThreads);
+	TaskPool(const TaskPool &) = delete;
+	TaskPool &operator=(const TaskPool &) = delete;
+	~TaskPool();
+
+	int getNumThreads() const;
+	void submit(function<void()> task);
+	void runUntil(const atomic<int> &pending);
+	template <class Body> void parallelFor(int begin, int end, int grain, Body body);
+};
+
+/*
+ * Tasks run in a pool and waited for together (fork-join). The thread that
+ * waits runs tasks of the pool in the meantime, so tasks can start and
+ * wait for other tasks.
+ */
+class TaskGroup {
+	TaskPool &pool;
+	atomic<int> pending;
+public:
+	explicit TaskGroup(TaskPool &pool);
+	~TaskGroup();
+	void run(function<void()> task);
+	void wait();
+};
+
+/*
+ * Runs body(from, to) over consecutive parts of [begin, end) with at most
+ * grain elements each, as tasks of the pool, and waits for all of them.
+ */
+template <class Body>
+void TaskPool::parallelFor(int begin, int end, int grain, Body body) {
+	if (end - begin <= grain) {
+		if (begin < end)
+			body(begin, end);
+		return;
+	}
+	int middle = begin + (end - begin) / 2;
+	TaskGroup group(*this);
+	group.run([this, begin, middle, grain, &body] { parallelFor(begin, middle, grain, body); });
+	parallelFor(middle, end, grain, body);
+	group.wait();
+}
+
+#endif /* TASKPOOL_H_ */
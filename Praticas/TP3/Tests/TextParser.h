@@ -0,0 +1,148 @@
+/*
+ * TextParser.h
+ * Streaming parser of text files of numbers, such as the point files of TP3
+ * (x and y of each point) and the map files of TP6 ("id;x;y", "id;n1;n2").
+ * Reads the file in large blocks and converts the numbers with std::from_chars,
+ * without iostreams or temporary strings.
+ */
+
+#ifndef TEXTPARSER_H_
+#define TEXTPARSER_H_
+
+#include <cstdio>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <array>
+#include <charconv>
+
+using namespace std;
+
+/*
+ * Numbers are separated by any sequence of whitespace, ';' or ','.
+ * Reading stops at the end of the file or at the first token that is not a
+ * number of the requested type (see failed).
+ */
+class TextParser {
+	FILE *file = nullptr;
+	vector<char> buffer;
+	size_t pos = 0, end = 0;  // unread bytes of buffer
+	bool last = false;        // the whole file was read into buffer
+	bool error = false;
+
+	void fill();
+	static bool isSeparator(char c);
+public:
+	explicit TextParser(const string &fileName, size_t blockSize = 1 << 20);
+	TextParser(const TextParser &) = delete;
+	TextParser &operator=(const TextParser &) = delete;
+	~TextParser();
+
+	bool isOpen() const;
+	bool failed() const;
+	template <class Num> bool next(Num &value);
+	template <class Num, size_t N> size_t nextChunk(vector<array<Num, N>> &records, size_t maxRecords);
+};
+
+inline TextParser::TextParser(const string &fileName, size_t blockSize): buffer(blockSize) {
+	file = fopen(fileName.c_str(), "rb");
+	last = file == nullptr;
+}
+
+inline TextParser::~TextParser() {
+	if (file != nullptr)
+		fclose(file);
+}
+
+inline bool TextParser::isOpen() const {
+	return file != nullptr;
+}
+
+/*
+ * True if reading stopped at a token that is not a number.
+ */
+inline bool TextParser::failed() const {
+	return error;
+}
+
+inline bool TextParser::isSeparator(char c) {
+	return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == ';' || c == ',';
+}
+
+/*
+ * Moves the unread bytes to the beginning of the buffer and reads the next
+ * block after them (growing the buffer if a single token fills it).
+ */
+inline void TextParser::fill() {
+	if (last)
+		return;
+	copy(buffer.begin() + pos, buffer.begin() + end, buffer.begin());
+	end -= pos;
+	pos = 0;
+	if (end == buffer.size())
+		buffer.resize(2 * buffer.size());
+	size_t n = fread(buffer.data() + end, 1, buffer.size() - end, file);
+	end += n;
+	if (n == 0)
+		last = true;
+}
+
+/*
+ * Reads the next number into value. Returns false at the end of the file,
+ * or if the next token is not a number of type Num.
+ */
+template <class Num>
+bool TextParser::next(Num &value) {
+	while (true) {
+		while (pos < end && isSeparator(buffer[pos]))
+			pos++;
+		if (pos == end) {
+			if (last)
+				return false;
+			fill();
+			continue;
+		}
+		size_t stop = pos;
+		while (stop < end && !isSeparator(buffer[stop]))
+			stop++;
+		if (stop == end && !last) { // the token may continue in the next block
+			fill();
+			continue;
+		}
+		auto res = from_chars(buffer.data() + pos, buffer.data() + stop, value);
+		if (res.ec != errc() || res.ptr != buffer.data() + stop) {
+			error = true;
+			last = true;
+			pos = end;
+			return false;
+		}
+		pos = stop;
+		return true;
+	}
+}
+
+/*
+ * Reads up to maxRecords records of N numbers each (e.g. N = 2 for points,
+ * N = 3 for map nodes or edges), replacing the contents of records.
+ * Returns the number of records read; 0 when there are no more. A final
+ * incomplete record is discarded (and makes failed() true).
+ * Allows processing a file chunk by chunk, e.g. while the next chunk is read
+ * by another thread.
+ */
+template <class Num, size_t N>
+size_t TextParser::nextChunk(vector<array<Num, N>> &records, size_t maxRecords) {
+	records.clear();
+	array<Num, N> record;
+	while (records.size() < maxRecords) {
+		for (size_t i = 0; i < N; i++)
+			if (!next(record[i])) {
+				if (i > 0)
+					error = true;
+				return records.size();
+			}
+		records.push_back(record);
+	}
+	return records.size();
+}
+
+#endif /* TEXTPARSER_H_ */
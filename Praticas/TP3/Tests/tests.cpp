@@ -6,8 +6,18 @@
 #include <sys/timeb.h>
 #include "Point.h"
 #include "NearestPoints.h"
+#include "TextParser.h"
+#include "PointSet.h"
+#include "TaskPool.h"
+#include "KdTree.h"
+#include "ClosestPairTracker.h"
+#include "NearestPointsT.h"
+#include <atomic>
 #include <random>
 #include <stdlib.h>
+#include <chrono>
+#include <functional>
+#include <cstdio>
 
 using namespace std;
 using testing::Eq;
@@ -16,16 +26,11 @@ using testing::Eq;
  * Auxiliary function to read points from file to vector.
  */
 void readPoints(string in, vector<Point> &vp){
-    ifstream is(in.c_str());
+    TextParser is(in);
     vp.clear();
-    if (!is)
-        return;
-    while (!is.eof()) {
-        double x, y;
-        is >> x >> y;
-        Point p(x,y);
-        vp.push_back(p);
-    }
+    double x, y;
+    while (is.next(x) && is.next(y))
+        vp.push_back(Point(x, y));
 }
 
 /**
@@ -201,6 +206,471 @@ void testNearestPoints(NP_FUNC func, string alg) {
         return;
 }
 
+TEST(CAL_FP03, testReadPoints) {
+    string file = "Pontos_test.tmp";
+    ofstream("Pontos_test.tmp") << "1 2\n-3 4.5\r\n  6e2\t-7\n\n";
+    vector<Point> vp;
+    readPoints(file, vp);
+    ASSERT_EQ(3u, vp.size()); // no spurious point after the final newline
+    EXPECT_EQ(Point(-3.0, 4.5), vp[1]);
+    EXPECT_EQ(Point(600.0, -7.0), vp[2]);
+
+    ofstream("Pontos_test.tmp") << "1 2 3 x 5";
+    TextParser parser(file);
+    double d;
+    EXPECT_TRUE(parser.next(d) && parser.next(d) && parser.next(d));
+    EXPECT_FALSE(parser.next(d));
+    EXPECT_TRUE(parser.failed());
+    remove(file.c_str());
+
+    readPoints("Pontos_missing", vp);
+    EXPECT_TRUE(vp.empty());
+
+    // chunks, with blocks smaller than a line
+    readPoints("Pontos128k", vp);
+    ASSERT_EQ(0x20000u, vp.size());
+    TextParser chunked("Pontos128k", 5);
+    vector<array<double, 2>> chunk;
+    unsigned i = 0;
+    while (chunked.nextChunk(chunk, 1000) > 0)
+        for (auto &p : chunk) {
+            ASSERT_EQ(vp[i], Point(p[0], p[1]));
+            i++;
+        }
+    EXPECT_EQ(vp.size(), i);
+    EXPECT_FALSE(chunked.failed());
+}
+
+/**
+ * The previous readPoints, with iostream extraction, as a baseline.
+ */
+void readPointsStream(string in, vector<Point> &vp){
+    ifstream is(in.c_str());
+    vp.clear();
+    double x, y;
+    while (is >> x >> y)
+        vp.push_back(Point(x, y));
+}
+
+TEST(CAL_FP03, testPerformanceReadPoints) {
+    string file = "Pontos2M_test.tmp";
+    vector<Point> generated, vp;
+    generateRandom(0x200000, generated);
+    {
+        ofstream os(file);
+        for (auto &p : generated)
+            os << (int) p.x << "\n" << (int) p.y << "\n"; // coordinates are integers
+    }
+    auto start = chrono::high_resolution_clock::now();
+    readPointsStream(file, vp);
+    auto finish = chrono::high_resolution_clock::now();
+    cout << "iostream, 2M points (ms): " << chrono::duration_cast<chrono::milliseconds>(finish - start).count() << endl;
+    EXPECT_EQ(generated.size(), vp.size());
+
+    start = chrono::high_resolution_clock::now();
+    readPoints(file, vp);
+    finish = chrono::high_resolution_clock::now();
+    cout << "TextParser, 2M points (ms): " << chrono::duration_cast<chrono::milliseconds>(finish - start).count() << endl;
+    ASSERT_EQ(generated.size(), vp.size());
+    for (unsigned i = 0; i < vp.size(); i++)
+        if (!(vp[i] == generated[i]))
+            FAIL() << "point " << i << " differs";
+    remove(file.c_str());
+}
+
+TEST(CAL_FP03, testPointSetNearest) {
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<double> dis(-100, 100);
+    vector<Point> vp;
+    for (int i = 0; i < 50; i++)
+        vp.push_back(Point(dis(gen), dis(gen)));
+    PointSet ps(vp);
+    ASSERT_EQ(50, ps.size());
+    EXPECT_EQ(vp[7], ps.getPoint(7));
+    // all the ranges, with all the alignments of the SIMD groups
+    for (int from = 0; from < 12; from++)
+        for (int to = from; to <= 50; to++)
+            for (double bound : {1e300, 500.0, 10.0}) {
+                double expected = bound, found = bound;
+                int expectedIndex = -1;
+                for (int j = from; j < to; j++)
+                    if (vp[j].distSquare(vp[49]) < expected) {
+                        expected = vp[j].distSquare(vp[49]);
+                        expectedIndex = j;
+                    }
+                ASSERT_EQ(expectedIndex, ps.nearest(vp[49].x, vp[49].y, from, to, found));
+                ASSERT_EQ(expected, found);
+            }
+    // the first one, on ties
+    PointSet same(vector<Point>(9, Point(1, 1)));
+    double d = 10;
+    EXPECT_EQ(2, same.nearest(0, 0, 2, 9, d));
+    EXPECT_EQ(2.0, d);
+}
+
+/**
+ * The previous brute force, with the points stored as Point objects and
+ * distance (with a square root) computed twice per improving pair, as a baseline.
+ */
+Result nearestPointsBFPoint(vector<Point> &vp) {
+    Result res;
+    for (unsigned i = 0; i < vp.size(); i++)
+        for (unsigned j = i + 1; j < vp.size(); j++)
+            if (vp[i].distance(vp[j]) < res.dmin) {
+                res.dmin = vp[i].distance(vp[j]);
+                res.p1 = vp[i];
+                res.p2 = vp[j];
+            }
+    return res;
+}
+
+TEST(CAL_FP03, testPerformanceBF) {
+    vector<Point> vp;
+    readPoints("Pontos16k", vp);
+    auto start = chrono::high_resolution_clock::now();
+    Result expected = nearestPointsBFPoint(vp);
+    auto finish = chrono::high_resolution_clock::now();
+    cout << "Brute force with Point, 16k points (ms): " << chrono::duration_cast<chrono::milliseconds>(finish - start).count() << endl;
+
+    start = chrono::high_resolution_clock::now();
+    Result res = nearestPoints_BF(vp);
+    finish = chrono::high_resolution_clock::now();
+    cout << "Brute force with PointSet, 16k points (ms): " << chrono::duration_cast<chrono::milliseconds>(finish - start).count() << endl;
+    EXPECT_NEAR(13.0384, res.dmin, 0.01);
+    EXPECT_DOUBLE_EQ(expected.dmin, res.dmin);
+    EXPECT_EQ(expected.p1, res.p1);
+    EXPECT_EQ(expected.p2, res.p2);
+}
+
+long fibTasks(TaskPool &pool, int n) {
+    if (n < 2)
+        return n;
+    long a, b;
+    TaskGroup group(pool);
+    group.run([&] { a = fibTasks(pool, n - 1); });
+    b = fibTasks(pool, n - 2);
+    group.wait();
+    return a + b;
+}
+
+TEST(CAL_FP03, testTaskPool) {
+    for (int threads : {1, 2, 4, 8}) {
+        TaskPool pool(threads);
+        EXPECT_EQ(threads, pool.getNumThreads());
+        // nested tasks, waited for by tasks
+        EXPECT_EQ(6765, fibTasks(pool, 20));
+        // each element visited once
+        vector<int> visits(100000, 0);
+        atomic<int> parts(0);
+        pool.parallelFor(0, visits.size(), 1000, [&](int from, int to) {
+            parts++;
+            for (int i = from; i < to; i++)
+                visits[i]++;
+        });
+        EXPECT_EQ(vector<int>(100000, 1), visits);
+        EXPECT_EQ(128, parts);
+    }
+}
+
+TEST(CAL_FP03, testPerformanceDC_MT) {
+    vector<Point> generated, vp;
+    generateRandomConstX(0x200000, generated);
+    cout << "threads; Pontos2MConstX (ms); distance" << endl;
+    for (int threads : {1, 2, 4, 8}) {
+        setNumThreads(threads);
+        vp = generated;
+        auto start = chrono::high_resolution_clock::now();
+        Result res = nearestPoints_DC_MT(vp);
+        auto finish = chrono::high_resolution_clock::now();
+        cout << threads << "; " << chrono::duration_cast<chrono::milliseconds>(finish - start).count() << "; " << res.dmin << endl;
+        EXPECT_EQ(1.0, res.dmin);
+    }
+}
+
+TEST(CAL_FP03, testKdTree) {
+    std::mt19937 gen(2);
+    std::uniform_int_distribution<int> dis(-300, 300);  // with repeated coordinates and points
+    vector<Point> vp;
+    for (int i = 0; i < 3000; i++)
+        vp.push_back(Point(dis(gen), dis(gen)));
+    KdTree tree(vp, 4);
+    ASSERT_EQ(3000, tree.size());
+
+    for (int t = 0; t < 200; t++) {
+        Point q(dis(gen) + 0.5, dis(gen) + 0.0);
+        vector<pair<double, int>> byDist;
+        for (unsigned i = 0; i < vp.size(); i++)
+            byDist.push_back(make_pair(vp[i].distSquare(q), i));
+        sort(byDist.begin(), byDist.end());
+
+        EXPECT_EQ(byDist[0].first, vp[tree.nearest(q)].distSquare(q));
+        vector<int> knn = tree.nearestK(q, 10);
+        ASSERT_EQ(10u, knn.size());
+        for (int k = 0; k < 10; k++)
+            EXPECT_EQ(byDist[k].first, vp[knn[k]].distSquare(q));
+
+        vector<int> within = tree.withinRadius(q, 20), expected;
+        for (auto &e : byDist)
+            if (e.first <= 400)
+                expected.push_back(e.second);
+        sort(within.begin(), within.end());
+        sort(expected.begin(), expected.end());
+        EXPECT_EQ(expected, within);
+    }
+    EXPECT_EQ(3000u, tree.nearestK(Point(0, 0), 5000).size());
+    EXPECT_EQ(-1, KdTree(vector<Point>()).nearest(Point(0, 0)));
+
+    vector<pair<int, int>> pairs = tree.pairsWithin(3, 2), expected;
+    for (unsigned i = 0; i < vp.size(); i++)
+        for (unsigned j = i + 1; j < vp.size(); j++)
+            if (vp[i].distSquare(vp[j]) <= 9)
+                expected.push_back(make_pair(i, j));
+    sort(pairs.begin(), pairs.end());
+    EXPECT_EQ(expected, pairs);
+}
+
+TEST(CAL_FP03, testPerformanceKdTree) {
+    vector<Point> vp;
+    readPoints("Pontos128k", vp);
+    ASSERT_FALSE(vp.empty());
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<double> dis(-65536, 65536);
+    vector<Point> queries;
+    for (int i = 0; i < 100000; i++)
+        queries.push_back(Point(dis(gen), dis(gen)));
+
+    auto start = chrono::high_resolution_clock::now();
+    KdTree tree(vp, 4);
+    auto finish = chrono::high_resolution_clock::now();
+    cout << "k-d tree build, 128k points (ms): " << chrono::duration_cast<chrono::milliseconds>(finish - start).count() << endl;
+
+    // brute force: a scan of all the points per query (only for some queries)
+    PointSet ps(vp);
+    unsigned bfQueries = 1000;
+    vector<int> bfNearest(bfQueries);
+    start = chrono::high_resolution_clock::now();
+    for (unsigned i = 0; i < bfQueries; i++) {
+        double d = numeric_limits<double>::infinity();
+        bfNearest[i] = ps.nearest(queries[i].x, queries[i].y, 0, ps.size(), d);
+    }
+    finish = chrono::high_resolution_clock::now();
+    cout << "brute force, nearest, per 100k queries (ms): "
+         << chrono::duration_cast<chrono::milliseconds>(finish - start).count() * (100000 / bfQueries) << endl;
+
+    vector<int> nearest(queries.size());
+    start = chrono::high_resolution_clock::now();
+    for (unsigned i = 0; i < queries.size(); i++)
+        nearest[i] = tree.nearest(queries[i]);
+    finish = chrono::high_resolution_clock::now();
+    cout << "k-d tree, nearest, 100k queries (ms): " << chrono::duration_cast<chrono::milliseconds>(finish - start).count() << endl;
+    for (unsigned i = 0; i < bfQueries; i++)
+        ASSERT_EQ(vp[bfNearest[i]].distSquare(queries[i]), vp[nearest[i]].distSquare(queries[i]));
+
+    long bfFound = 0, found = 0;
+    start = chrono::high_resolution_clock::now();
+    for (unsigned i = 0; i < bfQueries; i++)
+        for (auto &p : vp)
+            if (p.distSquare(queries[i]) <= 1000 * 1000)
+                bfFound++;
+    finish = chrono::high_resolution_clock::now();
+    cout << "brute force, radius 1000, per 100k queries (ms): "
+         << chrono::duration_cast<chrono::milliseconds>(finish - start).count() * (100000 / bfQueries) << endl;
+    start = chrono::high_resolution_clock::now();
+    for (unsigned i = 0; i < queries.size(); i++) {
+        long n = tree.withinRadius(queries[i], 1000).size();
+        if (i < bfQueries)
+            found += n;
+    }
+    finish = chrono::high_resolution_clock::now();
+    cout << "k-d tree, radius 1000, 100k queries (ms): " << chrono::duration_cast<chrono::milliseconds>(finish - start).count() << endl;
+    EXPECT_EQ(bfFound, found);
+
+    start = chrono::high_resolution_clock::now();
+    vector<pair<int, int>> pairs = tree.pairsWithin(20, 4);
+    finish = chrono::high_resolution_clock::now();
+    cout << "k-d tree, pairs within 20 (ms): " << chrono::duration_cast<chrono::milliseconds>(finish - start).count()
+         << "; " << pairs.size() << " pairs" << endl;
+    EXPECT_FALSE(pairs.empty());
+}
+
+TEST(CAL_FP03, testClosestPairTracker) {
+    std::mt19937 gen(4);
+    std::uniform_int_distribution<int> dis(0, 1000);
+    ClosestPairTracker tracker;
+    EXPECT_EQ(0, tracker.size());
+    tracker.insert(Point(1, 1));
+    EXPECT_EQ(Result().dmin, tracker.getResult().dmin);
+    EXPECT_FALSE(tracker.erase(5));
+
+    vector<Point> points(1, Point(1, 1));
+    vector<int> ids(1, 0);
+    for (int op = 0; op < 3000; op++) {
+        if (ids.size() > 2 && dis(gen) < 400) {
+            int k = dis(gen) % ids.size();
+            EXPECT_TRUE(tracker.erase(ids[k]));
+            EXPECT_FALSE(tracker.erase(ids[k]));
+            ids.erase(ids.begin() + k);
+        }
+        else {
+            points.push_back(Point(dis(gen) + 0.0, dis(gen) + 0.0));
+            ids.push_back(tracker.insert(points.back()));
+            EXPECT_EQ(points.size() - 1, ids.back());
+        }
+        ASSERT_EQ(ids.size(), tracker.size());
+        vector<Point> current;
+        for (int id : ids)
+            current.push_back(points[id]);
+        Result expected = nearestPoints_BF(current), res = tracker.getResult();
+        ASSERT_EQ(expected.dmin, res.dmin) << "after operation " << op;
+        EXPECT_EQ(res.dmin, res.p1.distance(res.p2));
+    }
+}
+
+TEST(CAL_FP03, testPerformanceClosestPairTracker) {
+    vector<Point> vp;
+    readPoints("Pontos64k", vp);
+    ASSERT_FALSE(vp.empty());
+    // replay: the points of the file arrive in order, and after each one
+    // a random current point expires, with probability 1/4
+    std::mt19937 gen(5);
+    std::uniform_int_distribution<int> dis(0, 3);
+    ClosestPairTracker tracker;
+    vector<int> ids;
+    vector<Point> current;
+    long updates = 0;
+    double checks = 0, dcTime = 0;
+    auto start = chrono::high_resolution_clock::now();
+    for (unsigned i = 0; i < vp.size(); i++) {
+        ids.push_back(tracker.insert(vp[i]));
+        updates++;
+        if (dis(gen) == 0) {
+            int k = gen() % ids.size();
+            tracker.erase(ids[k]);
+            ids[k] = ids.back();
+            ids.pop_back();
+            updates++;
+        }
+        if ((i + 1) % 8192 == 0) {
+            // checks with nearestPoints_DC, outside of the time measured
+            auto pause = chrono::high_resolution_clock::now();
+            current.clear();
+            for (int id : ids)
+                current.push_back(vp[id]);
+            Result expected = nearestPoints_DC(current);
+            auto resume = chrono::high_resolution_clock::now();
+            EXPECT_EQ(expected.dmin, tracker.getResult().dmin);
+            dcTime += chrono::duration<double, milli>(resume - pause).count();
+            checks++;
+            start += resume - pause;
+        }
+    }
+    auto finish = chrono::high_resolution_clock::now();
+    cout << "ClosestPairTracker, Pontos64k replay, " << updates << " updates (ms): "
+         << chrono::duration_cast<chrono::milliseconds>(finish - start).count() << endl;
+    cout << "nearestPoints_DC after each update, estimated (ms): " << (long) (dcTime / checks * updates) << endl;
+}
+
+TEST(CAL_FP03, testNearestPointsCoordTypes) {
+    // the data sets of testNearestPoints
+    vector<pair<string, function<void(vector<Point> &)>>> sets;
+    for (string file : {"Pontos8", "Pontos64", "Pontos1k", "Pontos16k", "Pontos32k", "Pontos64k", "Pontos128k"})
+        sets.push_back(make_pair(file, [file](vector<Point> &vp) { readPoints(file, vp); }));
+    string sizes[] = {"32k", "64k", "128k", "256k", "512k", "1M", "2M"};
+    for (int k = 3; k < 7; k++)
+        sets.push_back(make_pair("Pontos" + sizes[k], [k](vector<Point> &vp) { generateRandom(0x8000 << k, vp); }));
+    for (int k = 0; k < 7; k++)
+        sets.push_back(make_pair("Pontos" + sizes[k] + "ConstX", [k](vector<Point> &vp) { generateRandomConstX(0x8000 << k, vp); }));
+
+    vector<Point> points, vp;
+    for (auto &set : sets) {
+        set.second(points);
+        vp = points;
+        double expected = nearestPoints_DC_SortedY(vp).dmin;
+        vector<PointT<int32_t>> vi;
+        vector<PointT<float>> vf;
+        ASSERT_TRUE(convertPoints(points, vi)) << set.first;
+        ResultT<int32_t> ri = nearestPointsT_DC<int32_t>(vi);
+        EXPECT_EQ(expected, ri.dmin()) << set.first;
+        EXPECT_EQ(ri.dminSquare, ri.p1.distSquare(ri.p2)) << set.first;
+
+        // float holds exactly the integers up to 2^24 (the large ConstX sets go beyond)
+        bool exact = true;
+        for (auto &p : points)
+            exact = exact && fabs(p.x) <= (1 << 24) && fabs(p.y) <= (1 << 24);
+        EXPECT_EQ(exact, convertPoints(points, vf)) << set.first;
+        if (exact)
+            EXPECT_EQ(expected, nearestPointsT_DC<float>(vf).dmin()) << set.first;
+        else
+            EXPECT_TRUE(vf.empty()) << set.first;
+
+        if (points.size() <= 0x4000) {
+            vp = points;
+            expected = nearestPoints_BF(vp).dmin;
+            EXPECT_EQ(expected, nearestPointsT_BF<int32_t>(vi).dmin()) << set.first;
+            EXPECT_EQ(expected, nearestPointsT_BF<float>(vf).dmin()) << set.first;
+        }
+    }
+    vector<PointT<int32_t>> one(1), vi;
+    EXPECT_EQ(numeric_limits<double>::max(), nearestPointsT_DC<int32_t>(one).dmin());
+    vector<PointT<float>> vf;
+    EXPECT_TRUE(convertPoints(vector<Point>{Point(1 << 24, -(1 << 24))}, vf));
+    EXPECT_FALSE(convertPoints(vector<Point>{Point((1 << 24) + 1, 0)}, vf));
+    EXPECT_FALSE(convertPoints(vector<Point>{Point(0.1, 0.0)}, vf));
+    EXPECT_TRUE(convertPoints(vector<Point>{Point(-(1 << 30), (1 << 30) - 1)}, vi));
+    EXPECT_FALSE(convertPoints(vector<Point>{Point(1 << 30, 0)}, vi));
+    EXPECT_FALSE(convertPoints(vector<Point>{Point(0.5, 0.0)}, vi));
+
+    // squares far beyond 2^24, equal when rounded to float, are still told apart
+    int32_t a = (1 << 30) - 1;
+    vector<int32_t> xs(19, a), ys(19, 1);
+    ys[13] = 0;
+    int64_t minSquare = numeric_limits<int64_t>::max();
+    EXPECT_EQ(0, nearestSquare(xs.data(), ys.data(), 0, 13, 0, 0, minSquare));
+    EXPECT_EQ(13, nearestSquare(xs.data(), ys.data(), 1, 19, 0, 0, minSquare));
+    EXPECT_EQ((int64_t) a * a, minSquare);
+    EXPECT_EQ(-1, nearestSquare(xs.data(), ys.data(), 0, 19, -a, 0, minSquare));
+}
+
+TEST(CAL_FP03, testPerformanceCoordTypes) {
+    vector<Point> vp, points;
+    readPoints("Pontos16k", points);
+    vp = points;
+    auto start = chrono::high_resolution_clock::now();
+    nearestPoints_BF(vp);
+    auto finish = chrono::high_resolution_clock::now();
+    cout << "Brute force, 16k points, double (ms): " << chrono::duration_cast<chrono::milliseconds>(finish - start).count() << endl;
+    vector<PointT<float>> vf;
+    ASSERT_TRUE(convertPoints(points, vf));
+    start = chrono::high_resolution_clock::now();
+    nearestPointsT_BF<float>(vf);
+    finish = chrono::high_resolution_clock::now();
+    cout << "Brute force, 16k points, float (ms): " << chrono::duration_cast<chrono::milliseconds>(finish - start).count() << endl;
+    vector<PointT<int32_t>> vi;
+    ASSERT_TRUE(convertPoints(points, vi));
+    start = chrono::high_resolution_clock::now();
+    nearestPointsT_BF<int32_t>(vi);
+    finish = chrono::high_resolution_clock::now();
+    cout << "Brute force, 16k points, int32 (ms): " << chrono::duration_cast<chrono::milliseconds>(finish - start).count() << endl;
+
+    generateRandom(0x200000, points);
+    vp = points;
+    start = chrono::high_resolution_clock::now();
+    nearestPoints_DC_SortedY(vp);
+    finish = chrono::high_resolution_clock::now();
+    cout << "Divide and conquer, 2M points, double (ms): " << chrono::duration_cast<chrono::milliseconds>(finish - start).count() << endl;
+    ASSERT_TRUE(convertPoints(points, vf));
+    start = chrono::high_resolution_clock::now();
+    nearestPointsT_DC<float>(vf);
+    finish = chrono::high_resolution_clock::now();
+    cout << "Divide and conquer, 2M points, float (ms): " << chrono::duration_cast<chrono::milliseconds>(finish - start).count() << endl;
+    ASSERT_TRUE(convertPoints(points, vi));
+    start = chrono::high_resolution_clock::now();
+    ResultT<int32_t> res = nearestPointsT_DC<int32_t>(vi);
+    finish = chrono::high_resolution_clock::now();
+    cout << "Divide and conquer, 2M points, int32 (ms): " << chrono::duration_cast<chrono::milliseconds>(finish - start).count() << endl;
+    EXPECT_EQ(1, res.dminSquare);
+}
+
 /*
 TEST(CAL_FP03, testNP_BF) {
     testNearestPoints(nearestPoints_BF, "Brute force");
@@ -217,6 +687,28 @@ TEST(CAL_FP03, testNP_DC) {
 }
 
 
+TEST(CAL_FP03, testNP_DC_SortedY) {
+    testNearestPoints(nearestPoints_DC_SortedY, "Divide and conquer, merged by y");
+}
+
+
+TEST(CAL_FP03, testNP_Grid) {
+    testNearestPoints(nearestPoints_Grid, "Grid, randomized");
+
+    // repeated points: distance 0, found first or later
+    vector<Point> same(10, Point(3, 4));
+    EXPECT_EQ(0, nearestPoints_Grid(same).dmin);
+    vector<Point> once;
+    for (int i = 0; i < 1000; i++)
+        once.push_back(Point(i * 10, i % 7));
+    once.push_back(Point(500, 50 % 7));
+    Result res = nearestPoints_Grid(once);
+    EXPECT_EQ(0, res.dmin);
+    EXPECT_EQ(Point(500, 50 % 7), res.p1);
+    EXPECT_EQ(Point(500, 50 % 7), res.p2);
+}
+
+
 TEST(CAL_FP03, testNP_DC_2Threads) {
     setNumThreads(2);
     testNearestPoints(nearestPoints_DC_MT, "Divide and conquer with 2 threads");
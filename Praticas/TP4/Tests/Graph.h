@@ -7,6 +7,9 @@
 #include <vector>
 #include <queue>
 #include <list>
+#include <unordered_map>
+#include <functional>
+#include "DirectionOptimizingBFS.h"
 using namespace std;
 
 template <class T> class Edge;
@@ -20,9 +23,10 @@ template <class T>
 class Vertex {
 	T info;                // contents
 	vector<Edge<T> > adj;  // list of outgoing edges
-	bool visited;          // auxiliary field used by dfs and bfs
+	bool visited;          // auxiliary field used by dfs and isDAG
 	int indegree;          // auxiliary field used by topsort
 	bool processing;       // auxiliary field used by isDAG
+	int index;             // auxiliary field used by bfs (position in vertexSet)
 
 	void addEdge(Vertex<T> *dest, double w);
 	bool removeEdgeTo(Vertex<T> *d);
@@ -44,21 +48,35 @@ public:
 template <class T>
 class Graph {
 	vector<Vertex<T> *> vertexSet;    // vertex set
+	unordered_map<T, Vertex<T> *, function<size_t(const T &)>> vertexIndex; // optional, see setHasher
+	bool indexed = false;
+
+	int numThreads = 1;
+	mutable DirectionOptimizingBFS levels;  // adjacency by vertex index, for bfs
+	mutable bool levelsValid = false;       // levels is up to date
+	void bfsTree(Vertex<T> *src, vector<int> &order, vector<int> &parent) const;
+
+	// explicit stack of dfsVisit and dfsIsDAG: vertex and next edge to follow,
+	// kept between calls so that its memory is reused
+	mutable vector<pair<Vertex<T> *, unsigned>> dfsStack;
 
 	void dfsVisit(Vertex<T> *v,  vector<T> & res) const;
 	Vertex<T> *findVertex(const T &in) const;
 	bool dfsIsDAG(Vertex<T> *v) const;
 public:
 	int getNumVertex() const;
+	void setHasher(function<size_t(const T &)> hasher);
 	bool addVertex(const T &in);
 	bool removeVertex(const T &in);
 	bool addEdge(const T &sourc, const T &dest, double w);
 	bool removeEdge(const T &sourc, const T &dest);
 	vector<T> dfs() const;
+	vector<T> dfs(const T &source) const;
 	vector<T> bfs(const T &source) const;
 	vector<T> topsort() const;
 	int maxNewChildren(const T &source, T &inf) const;
 	bool isDAG() const;
+	void setNumThreads(int num);
 };
 
 /****************** Provided constructors and functions ********************/
@@ -75,11 +93,28 @@ int Graph<T>::getNumVertex() const {
 	return vertexSet.size();
 }
 
+/*
+ * Enables a hash index over the vertex contents, using the given hash function,
+ * so that findVertex runs in constant expected time instead of scanning vertexSet.
+ * Vertices already in the graph are indexed immediately.
+ */
+template <class T>
+void Graph<T>::setHasher(function<size_t(const T &)> hasher) {
+	vertexIndex = unordered_map<T, Vertex<T> *, function<size_t(const T &)>>(vertexSet.size(), hasher);
+	for (auto v : vertexSet)
+		vertexIndex.emplace(v->info, v);
+	indexed = true;
+}
+
 /*
  * Auxiliary function to find a vertex with a given content.
  */
 template <class T>
 Vertex<T> * Graph<T>::findVertex(const T &in) const {
+	if (indexed) {
+		auto it = vertexIndex.find(in);
+		return it == vertexIndex.end() ? NULL : it->second;
+	}
 	for (auto v : vertexSet)
 		if (v->info == in)
 			return v;
@@ -100,6 +135,9 @@ bool Graph<T>::addVertex(const T &in) {
 	    return false;
 
     this->vertexSet.push_back(new Vertex<T>(in));
+    levelsValid = false;
+    if (indexed)
+        vertexIndex.emplace(in, vertexSet.back());
     return true;
 }
 
@@ -121,6 +159,7 @@ bool Graph<T>::addEdge(const T &sourc, const T &dest, double w) {
 	    return false;
 
 	src->addEdge(des, w);
+	levelsValid = false;
 	return true;
 }
 
@@ -149,6 +188,7 @@ bool Graph<T>::removeEdge(const T &sourc, const T &dest) {
 	// HINT: Use the next function to actually remove the edge.
     Vertex<T> * src = findVertex(sourc), * des = findVertex(dest);
 
+    levelsValid = false;
     return !(src == NULL || des == NULL || !src->removeEdgeTo(des));
 
 }
@@ -206,7 +246,10 @@ bool Graph<T>::removeVertex(const T &in) {
             it++;
         }
 
+        if (indexed)
+            vertexIndex.erase(in);
         vertexSet.erase(aux);
+        levelsValid = false;
         return true;
     }
 
@@ -244,19 +287,47 @@ vector<T> Graph<T>::dfs() const {
 }
 
 /*
- * Auxiliary function that visits a vertex (v) and its adjacent not yet visited, recursively.
+ * Performs a depth-first search in a graph (this), starting from the vertex
+ * with the given source contents (source) and visiting only the vertices
+ * reachable from it. Returns their contents by dfs order.
+ */
+template <class T>
+vector<T> Graph<T>::dfs(const T &source) const {
+    vector<T> res;
+    for (auto v : vertexSet)
+        v->visited = false;
+    Vertex<T> *src = findVertex(source);
+    if (src != NULL)
+        dfsVisit(src, res);
+    return res;
+}
+
+/*
+ * Auxiliary function that visits a vertex (v) and its adjacent not yet visited.
  * Updates a parameter with the list of visited node contents.
+ * Uses an explicit stack instead of recursion (so that long paths do not
+ * overflow the call stack), visiting the vertices in the same order.
  */
 template <class T>
 void Graph<T>::dfsVisit(Vertex<T> *v, vector<T> & res) const {
 	// TODO (7 lines)
     v->visited = true;
     res.push_back(v->info);
-    typename vector<Edge<T>>::const_iterator it = v->adj.begin();
-    while (it != v->adj.end()) {
-        if (!(*it).dest->visited)
-            dfsVisit((*it).dest, res);
-        it++;
+    dfsStack.clear();
+    dfsStack.push_back(make_pair(v, 0));
+    while (!dfsStack.empty()) {
+        Vertex<T> *u = dfsStack.back().first;
+        unsigned i = dfsStack.back().second++;
+        if (i == u->adj.size()) {
+            dfsStack.pop_back();
+            continue;
+        }
+        Vertex<T> *w = u->adj[i].dest;
+        if (!w->visited) {
+            w->visited = true;
+            res.push_back(w->info);
+            dfsStack.push_back(make_pair(w, 0));
+        }
     }
 }
 
@@ -274,31 +345,43 @@ vector<T> Graph<T>::bfs(const T & source) const {
 	// HINT: Use the flag "visited" to mark newly discovered vertices .
 	// HINT: Use the "queue<>" class to temporarily store the vertices.
 	vector<T> res;
-    typename vector<Vertex<T> *>::const_iterator it = vertexSet.begin();
-    while (it != vertexSet.end()) {
-        (*it)->visited = false;
-        it++;
-    }
-    Vertex<T>* src = findVertex(source);
-    Vertex<T>* v;
-    queue<Vertex<T>*> Q;
-    Q.push(src);
+    vector<int> order, parent;
+    bfsTree(findVertex(source), order, parent);
+    for (int i : order)
+        res.push_back(vertexSet[i]->info);
 
-    while (!Q.empty()) {
-        v = Q.front();
-        Q.pop();
-        res.push_back(v->info);
-        typename vector<Edge<T>>::const_iterator it2 = v->adj.begin();
-        while (it2 != v->adj.end()) {
-            if (!(*it2).dest->visited) {
-                Q.push((*it2).dest);
-                (*it2).dest->visited = true;
-            }
-            it2++;
+    return res;
+}
+
+/*
+ * Auxiliary function that runs a breadth-first search from a vertex (src),
+ * with numThreads threads (see DirectionOptimizingBFS.h).
+ * Returns the indexes of the vertices reached, by bfs order, and the index
+ * of the vertex that discovered each vertex (-1 for src and unreached ones).
+ */
+template <class T>
+void Graph<T>::bfsTree(Vertex<T> *src, vector<int> &order, vector<int> &parent) const {
+    if (!levelsValid) {
+        vector<int> offsets(1, 0), targets;
+        for (unsigned i = 0; i < vertexSet.size(); i++) {
+            vertexSet[i]->index = i;
+            offsets.push_back(offsets.back() + vertexSet[i]->adj.size());
         }
+        for (auto v : vertexSet)
+            for (auto &e : v->adj)
+                targets.push_back(e.dest->index);
+        levels.build(offsets, targets);
+        levelsValid = true;
     }
+    levels.search(src->index, numThreads, order, parent);
+}
 
-	return res;
+/*
+ * Defines the number of threads used by bfs and maxNewChildren.
+ */
+template <class T>
+void Graph<T>::setNumThreads(int num) {
+    numThreads = num;
 }
 
 /****************** 2c) toposort ********************/
@@ -389,37 +472,19 @@ vector<T> Graph<T>::topsort() const {
 template <class T>
 int Graph<T>::maxNewChildren(const T & source, T &inf) const {
 	// TODO (28 lines, mostly reused)
-    typename vector<Vertex<T> *>::const_iterator it = vertexSet.begin();
-
-    while (it != vertexSet.end()) {
-        (*it)->visited = false;
-        it++;
-    }
+    Vertex<T>* src = findVertex(source);
+    vector<int> order, parent, count(vertexSet.size(), 0);
+    bfsTree(src, order, parent);
+    for (int i : order)
+        if (parent[i] != -1)
+            count[parent[i]]++;
 
-    Vertex<T>* src = findVertex(source), *v;
     inf = src->info;
-    queue<Vertex<T>*> Q;
-    Q.push(src);
-    typename vector<Edge<T>>::const_iterator it2;
-
-    int count, maxCount = 0;
-
-    while (!Q.empty()) {
-        v = Q.front();
-        Q.pop();
-        count = 0;
-        it2 = v->adj.begin();
-        while (it2 != v->adj.end()) {
-            if (!(*it2).dest->visited) {
-                count++;
-                Q.push((*it2).dest);
-                (*it2).dest->visited = true;
-            }
-            it2++;
-        }
-        if (count > maxCount) {
-            maxCount = count;
-            inf = v->info;
+    int maxCount = 0;
+    for (int i : order) {
+        if (count[i] > maxCount) {
+            maxCount = count[i];
+            inf = vertexSet[i]->info;
         }
     }
 
@@ -440,43 +505,50 @@ template <class T>
 bool Graph<T>::isDAG() const {
 	// TODO (9 lines, mostly reused)
 	// HINT: use the auxiliary field "processing" to mark the vertices in the stack.
-    typename vector<Vertex<T> *>::const_iterator it = vertexSet.begin();
-    while (it != vertexSet.end()) {
-        (*it)->processing = false;
-        it++;
+    for (auto v : vertexSet) {
+        v->visited = false;
+        v->processing = false;
     }
-    it = vertexSet.begin();
 
-    while(it != vertexSet.end()) {
-        if (!(*it)->processing) {
-            if (!dfsIsDAG(*it))
-                return false;
-        }
-        it++;
+    for (auto v : vertexSet) {
+        if (!v->visited && !dfsIsDAG(v))
+            return false;
     }
 
 	return true;
 }
 
 /**
- * Auxiliary function that visits a vertex (v) and its adjacent not yet visited, recursively.
+ * Auxiliary function that visits a vertex (v) and its adjacent not yet visited,
+ * with an explicit stack (see dfsVisit).
  * Returns false (not acyclic) if an edge to a vertex in the stack is found.
+ * Vertices already fully visited (visited, but not processing) are not
+ * visited again.
  */
 template <class T>
 bool Graph<T>::dfsIsDAG(Vertex<T> *v) const {
 	// TODO (12 lines, mostly reused)
+    v->visited = true;
     v->processing = true;
-    typename vector<Edge<T>>::const_iterator it = v->adj.begin();
-    while (it != v->adj.end()) {
-        if (!(*it).dest->processing) {
-            if (!dfsIsDAG((*it).dest))
-                return false;
-            it++;
+    dfsStack.clear();
+    dfsStack.push_back(make_pair(v, 0));
+    while (!dfsStack.empty()) {
+        Vertex<T> *u = dfsStack.back().first;
+        unsigned i = dfsStack.back().second++;
+        if (i == u->adj.size()) {
+            u->processing = false;
+            dfsStack.pop_back();
+            continue;
         }
-        else
+        Vertex<T> *w = u->adj[i].dest;
+        if (w->processing)
             return false;
+        if (!w->visited) {
+            w->visited = true;
+            w->processing = true;
+            dfsStack.push_back(make_pair(w, 0));
+        }
     }
-    v->processing = false;
 	return true;
 }
 
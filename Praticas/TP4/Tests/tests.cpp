@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <random>
+#include <chrono>
 #include "Graph.h"
 #include "Person.h"
 
@@ -92,6 +94,20 @@ TEST(CAL_FP04, test_removeEdge) {
     EXPECT_EQ(false, net1.removeEdge(p2,p3));
 }
 
+TEST(CAL_FP04, test_hashIndex) {
+    Graph<Person> net1;
+    net1.setHasher([](const Person &p) { return hash<string>()(p.getName()); });
+    createNetwork(net1);
+    Person p2("Carlos",33);
+    Person p8("Carlos",34);
+    EXPECT_EQ(false, net1.addVertex(p2));
+    EXPECT_EQ(true, net1.addVertex(p8));
+    EXPECT_EQ(true, net1.addEdge(p2,p8,0));
+    EXPECT_EQ(true, net1.removeVertex(p8));
+    EXPECT_EQ(false, net1.addEdge(p2,p8,0));
+    EXPECT_EQ(7, net1.getNumVertex());
+}
+
 TEST(CAL_FP04, test_dfs) {
     //uncomment test body below!
     Graph<Person> net1;
@@ -170,6 +186,235 @@ TEST(CAL_FP04, test_maxNewChildren) {
     EXPECT_EQ("Filipe", pt.getName());
 }
 
+/**
+ * Random social network with n people and about n * degree friendships,
+ * also returned as adjacency lists of people indexes (adj).
+ */
+void createRandomNetwork(int n, int degree, Graph<Person> & net, vector<vector<int>> & adj)
+{
+    mt19937 gen(n);
+    uniform_int_distribution<int> dis(0, n - 1);
+    vector<Person> people;
+    net.setHasher([](const Person &p) { return hash<string>()(p.getName()); });
+    for (int i = 0; i < n; i++) {
+        people.push_back(Person("P" + to_string(i), 18 + i % 70));
+        net.addVertex(people.back());
+    }
+    adj = vector<vector<int>>(n);
+    for (int i = 0; i < n; i++)
+        for (int k = 0; k < degree; k++) {
+            int j = dis(gen);
+            net.addEdge(people[i], people[j], 0);
+            adj[i].push_back(j);
+        }
+}
+
+TEST(CAL_FP04, test_bfs_threads) {
+    Graph<Person> net;
+    vector<vector<int>> adj;
+    createRandomNetwork(5000, 8, net, adj);
+
+    // usual queue-based bfs, from person 0, for the distance of each person
+    vector<int> expected(1, 0), dist(adj.size(), -1);
+    dist[0] = 0;
+    for (unsigned i = 0; i < expected.size(); i++)
+        for (int j : adj[expected[i]])
+            if (dist[j] == -1) {
+                dist[j] = dist[expected[i]] + 1;
+                expected.push_back(j);
+            }
+
+    // the bottom-up steps may pick other parents than the queue, so the
+    // order within a level may differ, but not with the number of threads
+    vector<Person> first;
+    int maxCount = 0;
+    Person maxPerson;
+    for (int threads = 1; threads <= 4; threads++) {
+        net.setNumThreads(threads);
+        vector<Person> v1 = net.bfs(Person("P0", 18));
+        ASSERT_EQ(expected.size(), v1.size());
+        for (unsigned i = 0; i < v1.size(); i++)
+            EXPECT_EQ(dist[expected[i]], dist[stoi(v1[i].getName().substr(1))]);
+        Person pt;
+        int count = net.maxNewChildren(Person("P0", 18), pt);
+        if (threads == 1) {
+            first = v1;
+            maxCount = count;
+            maxPerson = pt;
+            continue;
+        }
+        for (unsigned i = 0; i < v1.size(); i++)
+            EXPECT_EQ(first[i].getName(), v1[i].getName());
+        EXPECT_EQ(maxCount, count);
+        EXPECT_EQ(maxPerson.getName(), pt.getName());
+    }
+}
+
+/**
+ * Usual single-threaded queue-based bfs over adjacency lists, from s,
+ * as a baseline for the benchmark below.
+ */
+vector<int> queueBfs(int s, const vector<vector<int>> & adj)
+{
+    vector<int> res(1, s);
+    vector<bool> visited(adj.size(), false);
+    visited[s] = true;
+    for (unsigned i = 0; i < res.size(); i++)
+        for (int w : adj[res[i]])
+            if (!visited[w]) {
+                visited[w] = true;
+                res.push_back(w);
+            }
+    return res;
+}
+
+TEST(CAL_FP04, test_performance_bfs) {
+    int n = 200000;
+    Graph<Person> net;
+    vector<vector<int>> adj;
+    createRandomNetwork(n, 10, net, adj);
+    unsigned reached = net.bfs(Person("P0", 18)).size(); // also builds the adjacency arrays
+    auto start = chrono::high_resolution_clock::now();
+    vector<int> expected = queueBfs(0, adj);
+    auto finish = chrono::high_resolution_clock::now();
+    cout << "queue bfs " << n << " people (ms): "
+         << chrono::duration_cast<chrono::milliseconds>(finish - start).count() << endl;
+    EXPECT_EQ(reached, expected.size());
+    for (int threads = 1; threads <= 8; threads *= 2) {
+        net.setNumThreads(threads);
+        auto start = chrono::high_resolution_clock::now();
+        vector<Person> v1 = net.bfs(Person("P0", 18));
+        auto finish = chrono::high_resolution_clock::now();
+        cout << "bfs " << n << " people with " << threads << " threads (ms): "
+             << chrono::duration_cast<chrono::milliseconds>(finish - start).count() << endl;
+        EXPECT_EQ(reached, v1.size());
+    }
+}
+
+TEST(CAL_FP04, test_dfs_source) {
+    Graph<Person> net1;
+    createNetwork(net1);
+    vector<Person> v1 = net1.dfs(Person("Filipe", 20));
+    string names[] = {"Filipe", "Rui", "Carlos", "Maria", "Ana", "Ines", "Vasco"};
+    ASSERT_EQ(7u, v1.size());
+    for (unsigned i = 0; i < 7; i++)
+        EXPECT_EQ(names[i], v1[i].getName());
+    EXPECT_EQ(1u, net1.dfs(Person("Vasco", 28)).size());
+    EXPECT_EQ(0u, net1.dfs(Person("Vasco", 29)).size());
+}
+
+TEST(CAL_FP04, test_dfs_deep) {
+    // a path with one million vertices, too deep for a recursive dfs
+    int n = 1000000;
+    Graph<int> path;
+    path.setHasher([](const int &i) { return (size_t) i; });
+    for (int i = 0; i < n; i++)
+        path.addVertex(i);
+    for (int i = 1; i < n; i++)
+        path.addEdge(i - 1, i, 0);
+    vector<int> v1 = path.dfs();
+    ASSERT_EQ(n, (int) v1.size());
+    for (int i = 0; i < n; i++)
+        if (v1[i] != i)
+            FAIL() << "dfs order differs at " << i;
+    EXPECT_EQ(n, (int) path.dfs(0).size());
+    EXPECT_TRUE(path.isDAG());
+    path.addEdge(n - 1, 0, 0);
+    EXPECT_FALSE(path.isDAG());
+}
+
+/**
+ * Recursive dfs over adjacency lists, as a baseline for the benchmark below.
+ */
+void recursiveDfs(int v, const vector<vector<int>> & adj, vector<bool> & visited, vector<int> & res)
+{
+    visited[v] = true;
+    res.push_back(v);
+    for (int w : adj[v])
+        if (!visited[w])
+            recursiveDfs(w, adj, visited, res);
+}
+
+/**
+ * The same dfs with an explicit stack of (vertex, next edge), as in
+ * Graph::dfsVisit, over the same adjacency lists.
+ */
+void iterativeDfs(int v, const vector<vector<int>> & adj, vector<bool> & visited, vector<int> & res,
+                  vector<pair<int, unsigned>> & stack)
+{
+    visited[v] = true;
+    res.push_back(v);
+    stack.assign(1, make_pair(v, 0));
+    while (!stack.empty()) {
+        int u = stack.back().first;
+        unsigned i = stack.back().second++;
+        if (i == adj[u].size()) {
+            stack.pop_back();
+            continue;
+        }
+        int w = adj[u][i];
+        if (!visited[w]) {
+            visited[w] = true;
+            res.push_back(w);
+            stack.push_back(make_pair(w, 0));
+        }
+    }
+}
+
+TEST(CAL_FP04, test_performance_dfs) {
+    int n = 100000;
+    Graph<Person> net;
+    vector<vector<int>> wide;
+    createRandomNetwork(n, 10, net, wide);
+    // deep: a path, with the same people
+    Graph<Person> chain;
+    vector<vector<int>> deep(n);
+    chain.setHasher([](const Person &p) { return hash<string>()(p.getName()); });
+    for (int i = 0; i < n; i++)
+        chain.addVertex(Person("P" + to_string(i), 18 + i % 70));
+    for (int i = 1; i < n; i++) {
+        chain.addEdge(Person("P" + to_string(i - 1), 18 + (i - 1) % 70), Person("P" + to_string(i), 18 + i % 70), 0);
+        deep[i - 1].push_back(i);
+    }
+
+    Graph<Person> *graphs[] = {&chain, &net};
+    vector<vector<int>> *adjs[] = {&deep, &wide};
+    string names[] = {"deep", "wide"};
+    for (int k = 0; k < 2; k++) {
+        vector<bool> visited(n, false);
+        vector<int> expected;
+        auto start = chrono::high_resolution_clock::now();
+        for (int v = 0; v < n; v++)
+            if (!visited[v])
+                recursiveDfs(v, *adjs[k], visited, expected);
+        auto finish = chrono::high_resolution_clock::now();
+        cout << "recursive dfs, " << names[k] << " adjacency lists (ms): "
+             << chrono::duration_cast<chrono::milliseconds>(finish - start).count() << endl;
+        // recursion vs explicit stack, on the same adjacency lists
+        vector<int> iterative;
+        vector<pair<int, unsigned>> stack;
+        visited.assign(n, false);
+        start = chrono::high_resolution_clock::now();
+        for (int v = 0; v < n; v++)
+            if (!visited[v])
+                iterativeDfs(v, *adjs[k], visited, iterative, stack);
+        finish = chrono::high_resolution_clock::now();
+        cout << "iterative dfs, " << names[k] << " adjacency lists (ms): "
+             << chrono::duration_cast<chrono::milliseconds>(finish - start).count() << endl;
+        EXPECT_EQ(expected, iterative);
+        // and Graph::dfs, which also follows the edges of the Graph and copies the people
+        start = chrono::high_resolution_clock::now();
+        vector<Person> v1 = graphs[k]->dfs();
+        finish = chrono::high_resolution_clock::now();
+        cout << "Graph::dfs, " << names[k] << " graph (ms): "
+             << chrono::duration_cast<chrono::milliseconds>(finish - start).count() << endl;
+        ASSERT_EQ(expected.size(), v1.size());
+        for (int i = 0; i < n; i++)
+            if (v1[i].getName() != "P" + to_string(expected[i]))
+                FAIL() << "dfs order differs at " << i;
+    }
+}
+
 TEST(CAL_FP04, test_isDAG) {
     //uncomment test body below!
     Graph<int> myGraph;
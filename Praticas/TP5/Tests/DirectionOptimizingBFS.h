@@ -0,0 +1,182 @@
+/*
+ * DirectionOptimizingBFS.h
+ * Level-synchronous breadth-first search over a graph with dense vertex ids
+ * (0..n-1), which switches between top-down and bottom-up steps and splits
+ * each level across several threads. Used by Graph.
+ */
+
+#ifndef DIRECTIONOPTIMIZINGBFS_H_
+#define DIRECTIONOPTIMIZINGBFS_H_
+
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <cstdint>
+
+using namespace std;
+
+/*
+ * A top-down step scans the outgoing edges of the current level (frontier);
+ * a bottom-up step scans the incoming edges of the unvisited vertices, looking
+ * for a parent in the frontier (kept in a bitmap). Bottom-up is cheaper when
+ * the frontier is large, as most of its edges lead to visited vertices.
+ *
+ * A top-down step gives the result of the usual queue-based BFS: each vertex
+ * is discovered by the first vertex of the previous level, in order, with an
+ * edge to it, and the level is in the order of discovery. A bottom-up step
+ * stops at the first parent it finds in the frontier (the one with the lowest
+ * index), which may come later in the previous level, and then orders the
+ * level as a top-down step would with those parents: by the position of the
+ * parent, then of the edge among its outgoing edges. So the levels, and the
+ * whole result, are the same for any number of threads.
+ */
+class DirectionOptimizingBFS {
+	int n = 0;
+	vector<int> offsets, targets;           // outgoing edges, by source
+	vector<int> inOffsets, sources, slots;  // incoming edges, by target, with the position of
+	                                        // each edge among the outgoing edges of its source
+
+	// switch to bottom-up when the frontier has more than 1/ALPHA of the edges
+	// still to explore, and back to top-down when it has less than n/BETA vertices
+	static const int ALPHA = 14;
+	static const int BETA = 24;
+
+	template <class Task> static void parallelFor(unsigned numThreads, Task task);
+public:
+	void build(const vector<int> &offsets, const vector<int> &targets);
+	int getNumVertex() const;
+	void search(int source, int numThreads, vector<int> &order, vector<int> &parent) const;
+};
+
+/*
+ * Runs task(0), ..., task(numThreads-1), each in its own thread.
+ */
+template <class Task>
+void DirectionOptimizingBFS::parallelFor(unsigned numThreads, Task task) {
+	if (numThreads <= 1) {
+		task(0);
+		return;
+	}
+	vector<thread> threads;
+	for (unsigned t = 0; t < numThreads; t++)
+		threads.push_back(thread(task, t));
+	for (auto &t : threads)
+		t.join();
+}
+
+/*
+ * Sets the graph, in compressed sparse row form: the outgoing edges of
+ * vertex i go to targets[offsets[i]], ..., targets[offsets[i+1]-1], in order.
+ */
+inline void DirectionOptimizingBFS::build(const vector<int> &offsets, const vector<int> &targets) {
+	this->offsets = offsets;
+	this->targets = targets;
+	n = offsets.size() - 1;
+	inOffsets.assign(n + 1, 0);
+	for (int w : targets)
+		inOffsets[w + 1]++;
+	for (int v = 0; v < n; v++)
+		inOffsets[v + 1] += inOffsets[v];
+	sources.resize(targets.size());
+	slots.resize(targets.size());
+	vector<int> next(inOffsets.begin(), inOffsets.end() - 1);
+	for (int v = 0; v < n; v++)
+		for (int e = offsets[v]; e < offsets[v + 1]; e++) {
+			sources[next[targets[e]]] = v;
+			slots[next[targets[e]]++] = e - offsets[v];
+		}
+}
+
+inline int DirectionOptimizingBFS::getNumVertex() const {
+	return n;
+}
+
+/*
+ * Searches from source, with numThreads threads. Returns in order the
+ * vertices reached, by BFS order, and in parent the vertex that discovered
+ * each one (-1 for the source and the vertices not reached).
+ */
+inline void DirectionOptimizingBFS::search(int source, int numThreads, vector<int> &order, vector<int> &parent) const {
+	unsigned nt = max(numThreads, 1);
+	vector<char> visited(n, 0);
+	vector<int> pos(n, 0);                          // position of each vertex in its level
+	vector<uint64_t> frontier((n + 63) / 64, 0);    // bitmap of the current level
+	vector<uint64_t> key(n);                        // (parent position, edge slot), by bottom-up steps
+	vector<vector<int>> found(nt);                  // discovered vertices, by thread
+	order.assign(1, source);
+	parent.assign(n, -1);
+	visited[source] = 1;
+	long unexplored = targets.size() - (inOffsets[source + 1] - inOffsets[source]);
+	bool bottomUp = false;
+
+	for (size_t begin = 0; begin < order.size(); ) {
+		size_t end = order.size(), size = end - begin;
+		long frontierEdges = 0;
+		for (size_t i = begin; i < end; i++) {
+			pos[order[i]] = i - begin;
+			frontierEdges += offsets[order[i] + 1] - offsets[order[i]];
+		}
+		if (!bottomUp && frontierEdges > unexplored / ALPHA)
+			bottomUp = true;
+		else if (bottomUp && (long) size < n / BETA)
+			bottomUp = false;
+
+		if (bottomUp) {
+			fill(frontier.begin(), frontier.end(), 0);
+			for (size_t i = begin; i < end; i++)
+				frontier[order[i] / 64] |= (uint64_t) 1 << (order[i] % 64);
+			parallelFor(nt, [&](unsigned t) {
+				found[t].clear();
+				for (int w = (long) n * t / nt; w < (long) n * (t + 1) / nt; w++) {
+					if (visited[w])
+						continue;
+					// the incoming edges are by source, and those of a source by slot,
+					// so the first edge from the frontier is the first one of its parent
+					for (int e = inOffsets[w]; e < inOffsets[w + 1]; e++) {
+						int v = sources[e];
+						if (frontier[v / 64] >> (v % 64) & 1) {
+							key[w] = (uint64_t) pos[v] << 32 | slots[e];
+							found[t].push_back(w);
+							break;
+						}
+					}
+				}
+			});
+			size_t first = order.size();
+			for (auto &f : found)
+				for (int w : f) {
+					visited[w] = 1;
+					parent[w] = order[begin + (key[w] >> 32)];
+					order.push_back(w);
+					unexplored -= inOffsets[w + 1] - inOffsets[w];
+				}
+			sort(order.begin() + first, order.end(), [&key](int a, int b) { return key[a] < key[b]; });
+		}
+		else {
+			// each thread takes a contiguous part of the level, so the pairs
+			// (w, v) found, taken by thread, are in the order of a sequential scan
+			parallelFor(nt, [&](unsigned t) {
+				found[t].clear();
+				for (size_t i = begin + size * t / nt; i < begin + size * (t + 1) / nt; i++) {
+					int v = order[i];
+					for (int e = offsets[v]; e < offsets[v + 1]; e++)
+						if (!visited[targets[e]]) {
+							found[t].push_back(targets[e]);
+							found[t].push_back(v);
+						}
+				}
+			});
+			for (auto &f : found)
+				for (unsigned i = 0; i < f.size(); i += 2)
+					if (!visited[f[i]]) {
+						visited[f[i]] = 1;
+						parent[f[i]] = f[i + 1];
+						order.push_back(f[i]);
+						unexplored -= inOffsets[f[i] + 1] - inOffsets[f[i]];
+					}
+		}
+		begin = end;
+	}
+}
+
+#endif /* DIRECTIONOPTIMIZINGBFS_H_ */
@@ -0,0 +1,274 @@
+/*
+ * FrozenGraph.h
+ * Immutable compressed sparse row (CSR) snapshot of a Graph, for read-only
+ * shortest path queries. Obtained with Graph<T>::freeze().
+ */
+
+#ifndef FROZENGRAPH_H_
+#define FROZENGRAPH_H_
+
+#include <vector>
+#include <queue>
+#include <limits>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+
+using namespace std;
+
+template <class T> class Graph;
+
+#ifndef INF
+#define INF std::numeric_limits<double>::max()
+#endif
+
+/*
+ * Labels of a single source search (dist, path) over a FrozenGraph, in dense
+ * arrays indexed by vertex id, plus the auxiliary queue of the search.
+ * A query only modifies the context it is given, so several threads can query
+ * the same graph at once, each with its own context.
+ * Labels are reset lazily: an entry whose stamp is not the current generation
+ * is unset (dist INF, no path), so starting a new search is O(1).
+ */
+class SearchContext {
+	vector<double> dist;
+	vector<int> path;
+	vector<unsigned> stamp;
+	unsigned generation = 0;
+	vector<pair<double, int>> heap;   // reused by each search, to avoid allocations
+	vector<int> fifo;
+
+	template <class T> friend class FrozenGraph;
+public:
+	/*
+	 * Starts a new search over a graph with n vertices.
+	 */
+	void reset(int n) {
+		if ((int) stamp.size() != n || ++generation == 0) {
+			dist.assign(n, INF);
+			path.assign(n, -1);
+			stamp.assign(n, 0);
+			generation = 1;
+		}
+		heap.clear();
+		fifo.clear();
+	}
+	bool empty() const {
+		return generation == 0;
+	}
+	double getDist(int v) const {
+		return stamp[v] == generation ? dist[v] : INF;
+	}
+	int getPath(int v) const {
+		return stamp[v] == generation ? path[v] : -1;
+	}
+	void set(int v, double d, int p) {
+		stamp[v] = generation;
+		dist[v] = d;
+		path[v] = p;
+	}
+};
+
+/*
+ * Vertices are identified by dense integer ids (0..n-1), given by their
+ * position in the vertexSet of the original graph. The outgoing edges of
+ * vertex i are stored, contiguously, in positions [offsets[i], offsets[i+1])
+ * of the targets and weights arrays.
+ *
+ * Queries taking a SearchContext do not modify the graph and can run
+ * concurrently; the others store their results in the graph, like Graph does.
+ */
+template <class T>
+class FrozenGraph {
+	vector<T> info;            // contents, by vertex id
+	vector<int> offsets;       // first edge of each vertex (size n+1)
+	vector<int> targets;       // destination vertex id, by edge
+	vector<double> weights;    // edge weight, by edge
+	unordered_map<T, int, function<size_t(const T &)>> idIndex; // optional, see Graph::setHasher
+	bool indexed = false;
+
+	SearchContext last;        // results of the last query without context
+
+	FrozenGraph() = default;
+	int initSingleSource(const T &origin, SearchContext &ctx) const;
+	bool relax(int v, int w, double weight, SearchContext &ctx) const;
+
+public:
+	int getNumVertex() const;
+	int getNumEdges() const;
+	int findVertexId(const T &in) const;
+	T getInfo(int id) const;
+	double getDist(int id) const;
+	int getPathId(int id) const;
+
+	void dijkstraShortestPath(const T &s);
+	void unweightedShortestPath(const T &s);
+	void bellmanFordShortestPath(const T &s);
+	vector<T> getPathTo(const T &dest) const;
+
+	void dijkstraShortestPath(const T &s, SearchContext &ctx) const;
+	void unweightedShortestPath(const T &s, SearchContext &ctx) const;
+	void bellmanFordShortestPath(const T &s, SearchContext &ctx) const;
+	vector<T> getPathTo(const T &dest, const SearchContext &ctx) const;
+
+	friend class Graph<T>;
+};
+
+template <class T>
+int FrozenGraph<T>::getNumVertex() const {
+	return info.size();
+}
+
+template <class T>
+int FrozenGraph<T>::getNumEdges() const {
+	return targets.size();
+}
+
+/*
+ * Finds the id of the vertex with a given content, or -1 if there is none.
+ */
+template <class T>
+int FrozenGraph<T>::findVertexId(const T &in) const {
+	if (indexed) {
+		auto it = idIndex.find(in);
+		return it == idIndex.end() ? -1 : it->second;
+	}
+	for (unsigned i = 0; i < info.size(); i++)
+		if (info[i] == in)
+			return i;
+	return -1;
+}
+
+template <class T>
+T FrozenGraph<T>::getInfo(int id) const {
+	return info[id];
+}
+
+template <class T>
+double FrozenGraph<T>::getDist(int id) const {
+	return last.getDist(id);
+}
+
+/*
+ * Returns the id of the predecessor of a vertex in the last shortest path
+ * query, or -1 if the vertex is the source or was not reached.
+ */
+template <class T>
+int FrozenGraph<T>::getPathId(int id) const {
+	return last.getPath(id);
+}
+
+/**************** Single Source Shortest Path algorithms ************/
+
+/**
+ * Same as Graph<T>::initSingleSource, but returns the id of the source vertex,
+ * or -1 if it is not in the graph (ctx is then left with no vertex reached).
+ */
+template <class T>
+int FrozenGraph<T>::initSingleSource(const T &origin, SearchContext &ctx) const {
+	ctx.reset(info.size());
+	int s = findVertexId(origin);
+	if (s == -1)
+		return -1;
+	ctx.set(s, 0, -1);
+	return s;
+}
+
+template <class T>
+inline bool FrozenGraph<T>::relax(int v, int w, double weight, SearchContext &ctx) const {
+	double d = ctx.getDist(v) + weight;
+	if (d < ctx.getDist(w)) {
+		ctx.set(w, d, v);
+		return true;
+	}
+	else
+		return false;
+}
+
+template <class T>
+void FrozenGraph<T>::dijkstraShortestPath(const T &origin) {
+	dijkstraShortestPath(origin, last);
+}
+
+template <class T>
+void FrozenGraph<T>::unweightedShortestPath(const T &orig) {
+	unweightedShortestPath(orig, last);
+}
+
+template <class T>
+void FrozenGraph<T>::bellmanFordShortestPath(const T &orig) {
+	bellmanFordShortestPath(orig, last);
+}
+
+template <class T>
+vector<T> FrozenGraph<T>::getPathTo(const T &dest) const {
+	return getPathTo(dest, last);
+}
+
+/*
+ * Uses a binary heap with lazy deletion: instead of decreasing the key of a
+ * vertex already in the queue, a new entry is pushed and the old one is
+ * skipped when extracted.
+ */
+template <class T>
+void FrozenGraph<T>::dijkstraShortestPath(const T &origin, SearchContext &ctx) const {
+	int s = initSingleSource(origin, ctx);
+	if (s == -1)
+		return;
+	auto &q = ctx.heap;
+	auto cmp = greater<pair<double, int>>();
+	q.push_back(make_pair(0.0, s));
+	while( ! q.empty() ) {
+		pop_heap(q.begin(), q.end(), cmp);
+		auto top = q.back();
+		q.pop_back();
+		int v = top.second;
+		if (top.first > ctx.getDist(v))
+			continue; // stale entry
+		for (int e = offsets[v]; e < offsets[v + 1]; e++)
+			if (relax(v, targets[e], weights[e], ctx)) {
+				q.push_back(make_pair(ctx.getDist(targets[e]), targets[e]));
+				push_heap(q.begin(), q.end(), cmp);
+			}
+	}
+}
+
+template <class T>
+void FrozenGraph<T>::unweightedShortestPath(const T &orig, SearchContext &ctx) const {
+	int s = initSingleSource(orig, ctx);
+	if (s == -1)
+		return;
+	auto &q = ctx.fifo;
+	q.push_back(s);
+	for (unsigned head = 0; head < q.size(); head++) {
+		int v = q[head];
+		for (int e = offsets[v]; e < offsets[v + 1]; e++)
+			if (relax(v, targets[e], 1, ctx))
+				q.push_back(targets[e]);
+	}
+}
+
+template <class T>
+void FrozenGraph<T>::bellmanFordShortestPath(const T &orig, SearchContext &ctx) const {
+	if (initSingleSource(orig, ctx) == -1)
+		return;
+	int n = info.size();
+	for (int i = 1; i < n; i++)
+		for (int v = 0; v < n; v++)
+			for (int e = offsets[v]; e < offsets[v + 1]; e++)
+				relax(v, targets[e], weights[e], ctx);
+}
+
+template <class T>
+vector<T> FrozenGraph<T>::getPathTo(const T &dest, const SearchContext &ctx) const {
+	vector<T> res;
+	int v = findVertexId(dest);
+	if (v == -1 || ctx.empty() || ctx.getDist(v) == INF) // missing, not computed or disconnected
+		return res;
+	for ( ; v != -1; v = ctx.getPath(v))
+		res.push_back(info[v]);
+	reverse(res.begin(), res.end());
+	return res;
+}
+
+#endif /* FROZENGRAPH_H_ */
@@ -8,8 +8,13 @@
 #include <queue>
 #include <list>
 #include <limits>
+#include <climits>
+#include <unordered_map>
+#include <functional>
 #include <cmath>
 #include "MutablePriorityQueue.h"
+#include "FrozenGraph.h"
+#include "DirectionOptimizingBFS.h"
 
 using namespace std;
 
@@ -18,6 +23,7 @@ template <class T> class Graph;
 template <class T> class Vertex;
 
 #define INF std::numeric_limits<double>::max()
+#define MAX_BUCKET_WEIGHT 4096
 
 /************************* Vertex  **************************/
 
@@ -32,6 +38,8 @@ class Vertex {
 
 	bool visited = false;		// auxiliary field
 	bool processing = false;	// auxiliary field
+	int relaxCount = 0;			// auxiliary field
+	int index = 0;				// auxiliary field (position in vertexSet)
 
 	void addEdge(Vertex<T> *dest, double w);
 
@@ -100,22 +108,40 @@ Edge<T>::Edge(Vertex<T> *d, double w): dest(d), weight(w) {}
 template <class T>
 class Graph {
 	vector<Vertex<T> *> vertexSet;    // vertex set
+	unordered_map<T, Vertex<T> *, function<size_t(const T &)>> vertexIndex; // optional, see setHasher
+	bool indexed = false;
 
 	vector<vector<double>> dist;
 	vector<vector<Vertex<T>*>> pred;
 
+	bool integerWeights = true;    // all edge weights are non-negative integers
+	int maxWeight = 0;             // largest edge weight, when integerWeights
+	vector<vector<Vertex<T>*>> buckets; // of dialShortestPath, kept (empty) between queries
+	void dialShortestPath(Vertex<T> *src);
+
+	vector<T> negativeCycle;       // found by the last bellmanFordShortestPath
+	bool findNegativeCycle();
+
+	int numThreads = 1;
+	DirectionOptimizingBFS levels; // adjacency by vertex index, for unweightedShortestPath
+	bool levelsValid = false;      // levels is up to date
+
 public:
+	void setHasher(function<size_t(const T &)> hasher);
 	Vertex<T> *findVertex(const T &in) const;
 	bool addVertex(const T &in);
 	bool addEdge(const T &sourc, const T &dest, double w);
 	int getNumVertex() const;
 	vector<Vertex<T> *> getVertexSet() const;
+	FrozenGraph<T> freeze() const;
 
 	// Fp05 - single source
 	void unweightedShortestPath(const T &s);    //TODO...
-	void dijkstraShortestPath(const T &s);      //TODO...
-	void bellmanFordShortestPath(const T &s);   //TODO...
+	void dijkstraShortestPath(const T &s, bool buckets = false);      //TODO...
+	bool bellmanFordShortestPath(const T &s, bool queue = false);   //TODO...
 	vector<T> getPathTo(const T &dest) const;   //TODO...
+	vector<T> getNegativeCycle() const;
+	void setNumThreads(int num);
 
 	// Fp05 - all pairs
 	void floydWarshallShortestPath();   //TODO...
@@ -133,11 +159,28 @@ vector<Vertex<T> *> Graph<T>::getVertexSet() const {
 	return vertexSet;
 }
 
+/*
+ * Enables a hash index over the vertex contents, using the given hash function,
+ * so that findVertex runs in constant expected time instead of scanning vertexSet.
+ * Vertices already in the graph are indexed immediately.
+ */
+template <class T>
+void Graph<T>::setHasher(function<size_t(const T &)> hasher) {
+	vertexIndex = unordered_map<T, Vertex<T> *, function<size_t(const T &)>>(vertexSet.size(), hasher);
+	for (auto v : vertexSet)
+		vertexIndex.emplace(v->info, v);
+	indexed = true;
+}
+
 /*
  * Auxiliary function to find a vertex with a given content.
  */
 template <class T>
 Vertex<T> * Graph<T>::findVertex(const T &in) const {
+	if (indexed) {
+		auto it = vertexIndex.find(in);
+		return it == vertexIndex.end() ? NULL : it->second;
+	}
 	for (auto v : vertexSet)
 		if (v->info == in)
 			return v;
@@ -153,6 +196,9 @@ bool Graph<T>::addVertex(const T &in) {
 	if ( findVertex(in) != NULL)
 		return false;
 	vertexSet.push_back(new Vertex<T>(in));
+	levelsValid = false;
+	if (indexed)
+		vertexIndex.emplace(in, vertexSet.back());
 	return true;
 }
 
@@ -168,44 +214,105 @@ bool Graph<T>::addEdge(const T &sourc, const T &dest, double w) {
 	if (v1 == NULL || v2 == NULL)
 		return false;
 	v1->addEdge(v2,w);
+	levelsValid = false;
+	if (w < 0 || w != floor(w) || w > MAX_BUCKET_WEIGHT)
+		integerWeights = false;
+	else if (w > maxWeight)
+		maxWeight = w;
 	return true;
 }
 
 
+/*
+ * Builds an immutable CSR snapshot of the graph (see FrozenGraph.h).
+ * Vertex ids are the positions in vertexSet. Changes made to the graph
+ * afterwards are not reflected in the snapshot.
+ */
+template <class T>
+FrozenGraph<T> Graph<T>::freeze() const {
+	FrozenGraph<T> fg;
+	unsigned n = vertexSet.size();
+	unordered_map<Vertex<T> *, int> ids(n);
+	fg.info.reserve(n);
+	fg.offsets.reserve(n + 1);
+	fg.offsets.push_back(0);
+	for (unsigned i = 0; i < n; i++) {
+		ids[vertexSet[i]] = i;
+		fg.info.push_back(vertexSet[i]->info);
+		fg.offsets.push_back(fg.offsets.back() + vertexSet[i]->adj.size());
+	}
+	fg.targets.reserve(fg.offsets.back());
+	fg.weights.reserve(fg.offsets.back());
+	for (auto v : vertexSet)
+		for (auto &e : v->adj) {
+			fg.targets.push_back(ids[e.dest]);
+			fg.weights.push_back(e.weight);
+		}
+	if (indexed) {
+		fg.idIndex = unordered_map<T, int, function<size_t(const T &)>>(n, vertexIndex.hash_function());
+		for (unsigned i = 0; i < n; i++)
+			fg.idIndex.emplace(fg.info[i], i);
+		fg.indexed = true;
+	}
+	return fg;
+}
+
 /**************** Single Source Shortest Path algorithms ************/
 
+/*
+ * Breadth-first search with numThreads threads (see DirectionOptimizingBFS.h),
+ * over the vertex indexes, which are rebuilt after the graph changes.
+ */
 template<class T>
 void Graph<T>::unweightedShortestPath(const T &orig) {
 	// TODO
-	Vertex<T> *src = findVertex(orig), *v;
+	Vertex<T> *src = findVertex(orig);
 
     for (auto ver : vertexSet) {
         ver->dist = INT64_MAX;
         ver->path = NULL;
     }
 
-    src->dist = 0;
-    queue<Vertex<T>*> Q;
-    Q.push(src);
+    if (!levelsValid) {
+        vector<int> offsets(1, 0), targets;
+        for (unsigned i = 0; i < vertexSet.size(); i++) {
+            vertexSet[i]->index = i;
+            offsets.push_back(offsets.back() + vertexSet[i]->adj.size());
+        }
+        for (auto v : vertexSet)
+            for (auto &e : v->adj)
+                targets.push_back(e.dest->index);
+        levels.build(offsets, targets);
+        levelsValid = true;
+    }
 
-    while (!Q.empty()) {
-        v = Q.front();
-        Q.pop();
-        typename vector<Edge<T>>::const_iterator it2 = v->adj.begin();
-        while (it2 != v->adj.end()) {
-            if ((*it2).dest->dist == INT64_MAX) {
-                Q.push((*it2).dest);
-                (*it2).dest->dist = v->dist + 1;
-                (*it2).dest->path = v;
-            }
-            it2++;
+    vector<int> order, parent;
+    levels.search(src->index, numThreads, order, parent);
+    src->dist = 0;
+    for (int i : order) {
+        if (parent[i] != -1) {
+            vertexSet[i]->path = vertexSet[parent[i]];
+            vertexSet[i]->dist = vertexSet[parent[i]]->dist + 1;
         }
     }
+}
 
+/*
+ * Defines the number of threads used by unweightedShortestPath.
+ */
+template<class T>
+void Graph<T>::setNumThreads(int num) {
+    numThreads = num;
 }
 
+/*
+ * With buckets = true and small non-negative integer weights (up to MAX_BUCKET_WEIGHT,
+ * and no more than the number of vertices), uses a bucket queue (Dial's algorithm)
+ * instead of MutablePriorityQueue. Otherwise, or if the weights do not allow it,
+ * uses MutablePriorityQueue.
+ */
 template<class T>
-void Graph<T>::dijkstraShortestPath(const T &origin) {
+void Graph<T>::dijkstraShortestPath(const T &origin, bool buckets) {
 	// TODO
     for (auto ver : vertexSet) {
         ver->dist = INT_MAX;
@@ -214,6 +321,10 @@ void Graph<T>::dijkstraShortestPath(const T &origin) {
 
     Vertex<T> *src = findVertex(origin), *v;
     src->dist = 0;
+    if (buckets && integerWeights && maxWeight <= (int) vertexSet.size()) {
+        dialShortestPath(src);
+        return;
+    }
     MutablePriorityQueue<Vertex<T>> Q;
     Q.insert(src);
 
@@ -234,27 +345,140 @@ void Graph<T>::dijkstraShortestPath(const T &origin) {
     }
 }
 
+/*
+ * Dijkstra's algorithm with a circular array of maxWeight + 1 buckets, where bucket
+ * d % (maxWeight + 1) holds the vertices with tentative distance d. Since all tentative
+ * distances lie in [d, d + maxWeight], buckets are never shared by different distances.
+ * Decreased vertices are simply added to their new bucket; the old entries are
+ * skipped when found. Assumes dist and path are already initialized.
+ * The buckets are all empty at the end, and are reused by the next query.
+ */
+template<class T>
+void Graph<T>::dialShortestPath(Vertex<T> *src) {
+    int numBuckets = maxWeight + 1;
+    vector<vector<Vertex<T>*>> &B = buckets;
+    if ((int) B.size() < numBuckets)
+        B.resize(numBuckets);
+    B[0].push_back(src);
+    long pending = 1;
+
+    for (long d = 0; pending > 0; d++) {
+        vector<Vertex<T>*> &bucket = B[d % numBuckets];
+        while (!bucket.empty()) {
+            Vertex<T> *v = bucket.back();
+            bucket.pop_back();
+            pending--;
+            if (v->dist != d)
+                continue; // old entry of a decreased vertex
+            for (const Edge<T> &edge : v->adj) {
+                if (edge.dest->dist > v->dist + edge.weight) {
+                    edge.dest->dist = v->dist + edge.weight;
+                    edge.dest->path = v;
+                    B[(long) edge.dest->dist % numBuckets].push_back(edge.dest);
+                    pending++;
+                }
+            }
+        }
+    }
+}
+
+/*
+ * Stops as soon as a pass over the edges relaxes none of them.
+ * With queue, only the edges of the vertices whose distance changed are
+ * relaxed (SPFA); a vertex relaxed |V| times reveals a negative cycle.
+ * Returns false if a negative cycle is reachable from the source, which can
+ * then be obtained with getNegativeCycle.
+ */
 template<class T>
-void Graph<T>::bellmanFordShortestPath(const T &orig) {
+bool Graph<T>::bellmanFordShortestPath(const T &orig, bool queue) {
 	// TODO
     for (auto ver : vertexSet) {
-        ver->dist = INT_MAX;
+        ver->dist = INF;
         ver->path = NULL;
+        ver->processing = false;
+        ver->relaxCount = 0;
     }
+    negativeCycle.clear();
 
     Vertex<T> *src = findVertex(orig);
     src->dist = 0;
+    int n = vertexSet.size();
+
+    if (queue) {
+        std::queue<Vertex<T>*> Q;
+        Q.push(src);
+        src->processing = true;
+        while (!Q.empty()) {
+            Vertex<T> *v = Q.front();
+            Q.pop();
+            v->processing = false;
+            for (Edge<T> edge : v->adj) {
+                if (edge.dest->dist > v->dist + edge.weight) {
+                    edge.dest->dist = v->dist + edge.weight;
+                    edge.dest->path = v;
+                    if (++edge.dest->relaxCount % n == 0 && findNegativeCycle())
+                        return false;
+                    if (!edge.dest->processing) {
+                        edge.dest->processing = true;
+                        Q.push(edge.dest);
+                    }
+                }
+            }
+        }
+        return true;
+    }
 
-    for (int i = 1; i < vertexSet.size() - 1; i++) {
+    for (int i = 1; ; i++) {
+        bool changed = false;
         for (auto v : vertexSet) {
-            for(Edge<T> edge: v->adj) {
-                if(edge.dest->dist > v->dist + edge.weight){
+            for (Edge<T> edge : v->adj) {
+                if (edge.dest->dist > v->dist + edge.weight) {
                     edge.dest->dist = v->dist + edge.weight;
                     edge.dest->path = v;
+                    changed = true;
                 }
             }
         }
+        if (!changed)
+            return true;
+        if (i >= n && findNegativeCycle())
+            return false;
+    }
+}
+
+/*
+ * Looks for a cycle in the path pointers, which only appears when there is a
+ * negative cycle (and is then negative). Stores it in negativeCycle.
+ */
+template<class T>
+bool Graph<T>::findNegativeCycle() {
+    unordered_map<Vertex<T>*, Vertex<T>*> walk;   // first walk that reached each vertex
+    for (auto s : vertexSet) {
+        Vertex<T> *v = s;
+        while (v != NULL && walk.find(v) == walk.end()) {
+            walk[v] = s;
+            v = v->path;
+        }
+        if (v != NULL && walk[v] == s) {
+            negativeCycle.clear();
+            Vertex<T> *u = v;
+            do {
+                negativeCycle.insert(negativeCycle.begin(), u->info);
+                u = u->path;
+            } while (u != v);
+            return true;
+        }
     }
+    return false;
+}
+
+/*
+ * Negative cycle found by the last bellmanFordShortestPath, in the order of
+ * its edges; empty if there is none.
+ */
+template<class T>
+vector<T> Graph<T>::getNegativeCycle() const {
+    return negativeCycle;
 }
 
 
@@ -285,36 +509,36 @@ void Graph<T>::floydWarshallShortestPath() {
     pred.clear();
     pred = vector<vector<Vertex<T>*>>(vertexSet.size(), vector<Vertex<T>*>(vertexSet.size(), NULL));
 
-    // Build dist matrix
-	int i = 0, j = 0;
-    for (auto v1 : vertexSet) {
-        for (auto v2 : vertexSet) {
-            if (i == j)
-                dist[i][j] = 0;
-            else
-                for (Edge<T> edge: v1->adj)
-                    if (edge.dest->info == v2->info) {
-                        dist[i][j] = edge.weight;
-                        pred[i][j] = v1;
-                    }
-            j++;
+    // Build dist matrix, looking up the index of each edge destination
+    int n = vertexSet.size();
+    unordered_map<Vertex<T>*, int> index(n);
+    for (int i = 0; i < n; i++)
+        index[vertexSet[i]] = i;
+    for (int i = 0; i < n; i++) {
+        dist[i][i] = 0;
+        for (const Edge<T> &edge : vertexSet[i]->adj) {
+            int j = index[edge.dest];
+            if (i != j && edge.weight < dist[i][j]) {
+                dist[i][j] = edge.weight;
+                pred[i][j] = vertexSet[i];
+            }
         }
-        i++;
-        j = 0;
     }
 
-    for (int k = 0; k < vertexSet.size(); k++) {
-        int i = 0, j = 0;
-        for (auto v1 : vertexSet) {
-            for (auto v2 : vertexSet) {
-                if (dist[i][k] + dist[k][j] < dist[i][j]) {
-                    dist[i][j] = dist[i][k] + dist[k][j];
-                    pred[i][j] = pred[k][j];
+    for (int k = 0; k < n; k++) {
+        const vector<double> &distK = dist[k];
+        const vector<Vertex<T>*> &predK = pred[k];
+        for (int i = 0; i < n; i++) {
+            vector<double> &distI = dist[i];
+            double dik = distI[k];
+            if (dik == INT64_MAX)
+                continue; // no path from i to k
+            for (int j = 0; j < n; j++) {
+                if (dik + distK[j] < distI[j]) {
+                    distI[j] = dik + distK[j];
+                    pred[i][j] = predK[j];
                 }
-                j++;
             }
-            i++;
-            j = 0;
         }
     }
 }
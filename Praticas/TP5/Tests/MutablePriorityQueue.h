@@ -26,6 +26,7 @@ class MutablePriorityQueue {
 	inline void set(unsigned i, T * x);
 public:
 	MutablePriorityQueue();
+	template <class Iterator> MutablePriorityQueue(Iterator first, Iterator last);
 	void insert(T * x);
 	T * extractMin();
 	void decreaseKey(T * x);
@@ -44,6 +45,22 @@ MutablePriorityQueue<T>::MutablePriorityQueue() {
 	// to facilitate parent/child calculations
 }
 
+/*
+ * Builds a queue with the elements in the range [first, last) in linear time,
+ * by placing them in any order and then heapifying down from the last parent.
+ */
+template <class T>
+template <class Iterator>
+MutablePriorityQueue<T>::MutablePriorityQueue(Iterator first, Iterator last) {
+	H.push_back(nullptr);
+	for ( ; first != last; ++first) {
+		H.push_back(*first);
+		H.back()->queueIndex = H.size() - 1;
+	}
+	for (unsigned i = parent(H.size() - 1); i >= 1; i--)
+		heapifyDown(i);
+}
+
 template <class T>
 bool MutablePriorityQueue<T>::empty() {
 	return H.size() == 1;
@@ -103,12 +120,13 @@ void MutablePriorityQueue<T>::set(unsigned i, T * x) {
 	x->queueIndex = i;
 }
 
+/*
+ * Constant time membership test, using the element's queueIndex
+ * (set to 0 by extractMin when an element leaves the queue).
+ */
 template<class T>
 bool MutablePriorityQueue<T>::inQueue(T * x) {
-    for (auto v : H)
-        if (v == x)
-            return true;
-    return false;
+    return x->queueIndex > 0 && x->queueIndex < (int) H.size() && H[x->queueIndex] == x;
 }
 
 #endif /* SRC_MUTABLEPRIORITYQUEUE_H_ */
@@ -5,6 +5,8 @@
 #include <random>
 #include <time.h>
 #include <chrono>
+#include <algorithm>
+#include <thread>
 #include "Graph.h"
 
 using namespace std;
@@ -51,6 +53,7 @@ void geneateRandomGridGraph(int n, Graph<pair<int,int>> & g) {
     std::mt19937 gen(rd());
     std::uniform_int_distribution<int> dis(1, n);
 
+    g.setHasher([n](const pair<int,int> &p) { return (size_t) (p.first * n + p.second); });
     for (int i = 0; i < n; i++)
         for (int j = 0; j < n; j++)
             g.addVertex(make_pair(i,j));
@@ -100,6 +103,30 @@ TEST(CAL_FP05, test_unweightedShortestPath) {
     checkSinglePath(myGraph.getPathTo(6), "5 7 6 ");
 }
 
+TEST(CAL_FP05, test_unweightedShortestPath_threads) {
+    Graph< pair<int,int> > g;
+    geneateRandomGridGraph(40, g);
+    g.addVertex(make_pair(-1, -1));
+    FrozenGraph< pair<int,int> > frozen = g.freeze();
+    frozen.unweightedShortestPath(make_pair(3, 5));
+    for (int threads = 1; threads <= 4; threads++) {
+        g.setNumThreads(threads);
+        g.unweightedShortestPath(make_pair(3, 5));
+        for (auto v : g.getVertexSet()) {
+            int id = frozen.findVertexId(v->getInfo());
+            if (frozen.getPathId(id) == -1) {
+                EXPECT_EQ(NULL, v->getPath());
+            }
+            else {
+                EXPECT_EQ(frozen.getInfo(frozen.getPathId(id)), v->getPath()->getInfo());
+            }
+            if (frozen.getDist(id) != INF) {
+                EXPECT_EQ(frozen.getDist(id), v->getDist());
+            }
+        }
+    }
+}
+
 
 //Uncomment the test below...
 TEST(CAL_FP05, test_dijkstra) {
@@ -119,23 +146,260 @@ TEST(CAL_FP05, test_dijkstra) {
     checkSinglePath(myGraph.getPathTo(1), "7 6 4 3 1 ");
 }
 
-/*
-//Uncomment the test below...
+TEST(CAL_FP05, test_hashIndex) {
+    Graph<int> myGraph = CreateTestGraph();
+    myGraph.setHasher([](const int &i) { return hash<int>()(i); });
+
+    EXPECT_EQ(7, myGraph.findVertex(7)->getInfo());
+    EXPECT_EQ(NULL, myGraph.findVertex(8));
+    EXPECT_EQ(true, myGraph.addVertex(8));
+    EXPECT_EQ(false, myGraph.addVertex(8));
+    EXPECT_EQ(true, myGraph.addEdge(7, 8, 1));
+
+    myGraph.dijkstraShortestPath(1);
+    checkSinglePath(myGraph.getPathTo(8), "1 2 4 5 7 8 ");
+}
+
+TEST(CAL_FP05, test_freeze) {
+    Graph<int> myGraph = CreateTestGraph();
+    FrozenGraph<int> frozen = myGraph.freeze();
+    EXPECT_EQ(7, frozen.getNumVertex());
+    EXPECT_EQ(13, frozen.getNumEdges());
+
+    frozen.unweightedShortestPath(3);
+    checkSinglePath(frozen.getPathTo(7), "3 1 4 7 ");
+
+    frozen.dijkstraShortestPath(1);
+    checkSinglePath(frozen.getPathTo(7), "1 2 4 5 7 ");
+    EXPECT_EQ(8, frozen.getDist(frozen.findVertexId(7)));
+
+    frozen.dijkstraShortestPath(7);
+    checkSinglePath(frozen.getPathTo(1), "7 6 4 3 1 ");
+
+    frozen.bellmanFordShortestPath(5);
+    checkSinglePath(frozen.getPathTo(6), "5 7 6 ");
+    // source not in the graph: nothing reached
+    frozen.dijkstraShortestPath(99);
+    EXPECT_TRUE(frozen.getPathTo(6).empty());
+    frozen.unweightedShortestPath(99);
+    EXPECT_TRUE(frozen.getPathTo(6).empty());
+    frozen.bellmanFordShortestPath(99);
+    EXPECT_TRUE(frozen.getPathTo(6).empty());
+}
+
+TEST(CAL_FP05, test_freeze_grid) {
+    Graph< pair<int,int> > g;
+    geneateRandomGridGraph(20, g);
+    FrozenGraph< pair<int,int> > frozen = g.freeze();
+    for (int i = 0; i < 20; i += 7) {
+        g.dijkstraShortestPath(make_pair(i, i));
+        frozen.dijkstraShortestPath(make_pair(i, i));
+        for (auto v : g.getVertexSet())
+            EXPECT_EQ(v->getDist(), frozen.getDist(frozen.findVertexId(v->getInfo())));
+    }
+}
+
+TEST(CAL_FP05, test_freeze_concurrent) {
+    Graph<int> myGraph = CreateTestGraph();
+    const FrozenGraph<int> frozen = myGraph.freeze();
+
+    // one search context per thread, all sharing the same frozen graph
+    vector<string> paths(7);
+    vector<thread> threads;
+    for (int s = 1; s <= 7; s++)
+        threads.push_back(thread([&, s]() {
+            SearchContext ctx;
+            for (int k = 0; k < 100; k++)
+                frozen.dijkstraShortestPath(s, ctx);
+            stringstream ss;
+            for (int v : frozen.getPathTo(s == 7 ? 1 : 7, ctx))
+                ss << v << " ";
+            paths[s - 1] = ss.str();
+        }));
+    for (auto &t : threads)
+        t.join();
+
+    EXPECT_EQ("1 2 4 5 7 ", paths[0]);
+    EXPECT_EQ("7 6 4 3 1 ", paths[6]);
+
+    SearchContext ctx;
+    for (int s = 1; s <= 7; s++) {
+        frozen.dijkstraShortestPath(s, ctx);
+        myGraph.dijkstraShortestPath(s);
+        for (auto v : myGraph.getVertexSet())
+            EXPECT_EQ(v->getDist(), ctx.getDist(frozen.findVertexId(v->getInfo())));
+    }
+}
+
+/**
+ * Auxiliary structures to benchmark the priority queue on its own,
+ * with grids built like in geneateRandomGridGraph.
+ */
+struct QueueNode {
+    double dist = 0;
+    int queueIndex = 0;
+    vector<pair<QueueNode*, double>> adj;
+    bool operator<(QueueNode & n) const { return dist < n.dist; }
+};
+
+void generateRandomQueueGrid(int n, vector<QueueNode> & nodes) {
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::uniform_int_distribution<int> dis(1, n);
+
+    nodes = vector<QueueNode>(n * n);
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+            for (int di = -1; di <= 1; di++)
+                for (int dj = -1; dj <= 1; dj++)
+                    if ((di != 0) != (dj != 0) && i+di >= 0 && i+di < n && j+dj >= 0 && j+dj < n)
+                        nodes[i*n+j].adj.push_back(make_pair(&nodes[(i+di)*n+j+dj], dis(gen)));
+}
+
+/**
+ * Queue with the linear membership test that MutablePriorityQueue used to have,
+ * kept as a baseline for the benchmark below.
+ */
+template <class T>
+class LinearMembershipQueue {
+    MutablePriorityQueue<T> q;
+    vector<T *> elems;
+public:
+    void insert(T * x) { q.insert(x); elems.push_back(x); }
+    void decreaseKey(T * x) { q.decreaseKey(x); }
+    bool empty() { return q.empty(); }
+    bool inQueue(T * x) { return find(elems.begin(), elems.end(), x) != elems.end(); }
+    T * extractMin() {
+        T * x = q.extractMin();
+        *find(elems.begin(), elems.end(), x) = elems.back();
+        elems.pop_back();
+        return x;
+    }
+};
+
+template <class Q>
+double queueDijkstra(vector<QueueNode> & nodes, int source) {
+    for (auto & v : nodes)
+        v.dist = INT_MAX;
+    nodes[source].dist = 0;
+    Q q;
+    q.insert(&nodes[source]);
+    while (!q.empty()) {
+        QueueNode * v = q.extractMin();
+        for (auto & e : v->adj)
+            if (e.first->dist > v->dist + e.second) {
+                e.first->dist = v->dist + e.second;
+                if (!q.inQueue(e.first))
+                    q.insert(e.first);
+                else
+                    q.decreaseKey(e.first);
+            }
+    }
+    double sum = 0;
+    for (auto & v : nodes)
+        sum += v.dist;
+    return sum;
+}
+
+TEST(CAL_FP05, test_heapify) {
+    vector<QueueNode> nodes(100);
+    for (int i = 0; i < 100; i++)
+        nodes[i].dist = (i * 37) % 100;
+    vector<QueueNode*> ptrs;
+    for (auto & v : nodes)
+        ptrs.push_back(&v);
+    MutablePriorityQueue<QueueNode> q(ptrs.begin(), ptrs.end());
+    for (auto v : ptrs)
+        EXPECT_TRUE(q.inQueue(v));
+    nodes[50].dist = -1;
+    q.decreaseKey(&nodes[50]);
+    EXPECT_EQ(&nodes[50], q.extractMin());
+    EXPECT_FALSE(q.inQueue(&nodes[50]));
+    for (int i = 0; i < 100; i++) {
+        if (i != 50) {
+            EXPECT_EQ(i, q.extractMin()->dist);
+        }
+    }
+    EXPECT_TRUE(q.empty());
+}
+
+TEST(CAL_FP05, test_performance_queue) {
+    for (int n = 20; n <= 100; n += 40) {
+        vector<QueueNode> nodes;
+        generateRandomQueueGrid(n, nodes);
+        long elapsed[2];
+        double sums[2];
+        for (int k = 0; k < 2; k++) {
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int s = 0; s < n*n; s += n + 1)
+                sums[k] = k == 0 ? queueDijkstra<LinearMembershipQueue<QueueNode>>(nodes, s)
+                                 : queueDijkstra<MutablePriorityQueue<QueueNode>>(nodes, s);
+            auto finish = std::chrono::high_resolution_clock::now();
+            elapsed[k] = chrono::duration_cast<chrono::microseconds>(finish - start).count();
+        }
+        EXPECT_EQ(sums[0], sums[1]);
+        cout << "Queue grid " << n << " x " << n << " total time (micro-seconds): linear inQueue="
+             << elapsed[0] << " queueIndex inQueue=" << elapsed[1] << endl;
+    }
+}
+
+TEST(CAL_FP05, test_dijkstra_buckets) {
+    Graph<int> myGraph = CreateTestGraph();
+
+    myGraph.dijkstraShortestPath(3, true);
+    checkAllPaths(myGraph, "1<-3|2<-1|3<-|4<-2|5<-4|6<-3|7<-5|");
+
+    myGraph.dijkstraShortestPath(1, true);
+    checkSinglePath(myGraph.getPathTo(7), "1 2 4 5 7 ");
+
+    myGraph.dijkstraShortestPath(7, true);
+    checkSinglePath(myGraph.getPathTo(1), "7 6 4 3 1 ");
+
+    // non-integer weight: falls back to the priority queue
+    myGraph.addEdge(7, 1, 0.5);
+    myGraph.dijkstraShortestPath(7, true);
+    checkSinglePath(myGraph.getPathTo(4), "7 1 2 4 ");
+
+    Graph< pair<int,int> > g;
+    geneateRandomGridGraph(30, g);
+    for (int i = 0; i < 30; i += 7) {
+        g.dijkstraShortestPath(make_pair(i, 29 - i));
+        vector<double> heapDist;
+        for (auto v : g.getVertexSet())
+            heapDist.push_back(v->getDist());
+        g.dijkstraShortestPath(make_pair(i, 29 - i), true);
+        for (unsigned k = 0; k < heapDist.size(); k++)
+            EXPECT_EQ(heapDist[k], g.getVertexSet()[k]->getDist());
+    }
+
+    // integer weights too large for buckets: falls back to the priority queue
+    Graph<int> big = CreateTestGraph();
+    big.addEdge(1, 7, 1000000);
+    big.addEdge(3, 7, 100);
+    big.dijkstraShortestPath(3, true);
+    checkSinglePath(big.getPathTo(7), "3 1 2 4 5 7 ");
+}
+
 TEST(CAL_FP05, test_performance_dijkstra) {
-    for (int n = 10; n <= 100; n += 10) {
+    // up to 25 x 25 evenly spread sources per grid, so that the larger grids stay quick
+    for (int n = 10; n <= 100; n += 30) {
         Graph< pair<int,int> > g;
         cout << "Dijkstra generating grid " << n << " x " << n << " ..." << endl;
         geneateRandomGridGraph(n, g);
-        cout << "Dijkstra processing grid " << n << " x " << n << " ..." << endl;
-        auto start = std::chrono::high_resolution_clock::now();
-        for (int i = 0; i < n; i++)
-            for (int j = 0; j < n; j++)
-                g.dijkstraShortestPath(make_pair(i,j));
-        auto finish = std::chrono::high_resolution_clock::now();
-        auto elapsed = chrono::duration_cast<chrono::microseconds>(finish - start).count();
-        cout << "Dijkstra processing grid " << n << " x " << n << " average time (micro-seconds)=" << (elapsed / (n*n)) << endl;
+        int step = max(1, n / 25), sources = ((n + step - 1) / step) * ((n + step - 1) / step);
+        for (bool buckets : {false, true}) {
+            cout << "Dijkstra processing grid " << n << " x " << n << (buckets ? " with buckets" : "") << " ..." << endl;
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < n; i += step)
+                for (int j = 0; j < n; j += step)
+                    g.dijkstraShortestPath(make_pair(i,j), buckets);
+            auto finish = std::chrono::high_resolution_clock::now();
+            auto elapsed = chrono::duration_cast<chrono::microseconds>(finish - start).count();
+            cout << "Dijkstra processing grid " << n << " x " << n << (buckets ? " with buckets" : "")
+                 << " average time (micro-seconds)=" << (elapsed / sources) << endl;
+        }
     }
-}*/
+}
 
 
 //Uncomment the test below...
@@ -153,6 +417,22 @@ TEST(CAL_FP05, test_bellmanFord) {
 
     myGraph.bellmanFordShortestPath(7);
     checkSinglePath(myGraph.getPathTo(1), "7 6 4 3 1 ");
+
+    for (bool queue : {false, true}) {
+        EXPECT_TRUE(myGraph.bellmanFordShortestPath(1, queue));
+        checkSinglePath(myGraph.getPathTo(7), "1 2 4 5 7 ");
+        EXPECT_TRUE(myGraph.getNegativeCycle().empty());
+    }
+
+    // 4 -> 5 -> 7 -> 6 -> 4 and 4 -> 7 -> 6 -> 4 become negative
+    myGraph.addEdge(7, 6, -10);
+    for (bool queue : {false, true}) {
+        EXPECT_FALSE(myGraph.bellmanFordShortestPath(1, queue));
+        vector<int> cycle = myGraph.getNegativeCycle();
+        ASSERT_FALSE(cycle.empty());
+        rotate(cycle.begin(), find(cycle.begin(), cycle.end(), 4), cycle.end());
+        EXPECT_TRUE(cycle == vector<int>({4, 5, 7, 6}) || cycle == vector<int>({4, 7, 6}));
+    }
 }
 
 
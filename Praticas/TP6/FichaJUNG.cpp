@@ -4,6 +4,7 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include "TextParser.h"
 using namespace std;
 
 void exercicio1();
@@ -112,37 +113,15 @@ void exercicio3()
     gv->defineVertexColor("blue");
     gv->defineEdgeColor("black");
 
-    ifstream edgeFile;
-    edgeFile.open("../resources/mapa1/arestas.txt");
-
-    ifstream nodeFile;
-    nodeFile.open("../resources/mapa1/nos.txt");
-
-    while (!nodeFile.eof()) {
-        string line;
-        int id, x, y;
-        getline(nodeFile, line, ';');
-        id = stoi(line);
-        getline(nodeFile, line, ';');
-        x = stoi(line);
-        getline(nodeFile, line, '\n');
-        y = stoi(line);
-
+    TextParser nodeFile("../resources/mapa1/nos.txt");
+    int id, x, y;
+    while (nodeFile.next(id) && nodeFile.next(x) && nodeFile.next(y))
         gv->addNode(id, x, y);
-    }
-
-    while (!edgeFile.eof()) {
-        string line;
-        int id, n1, n2;
-        getline(edgeFile, line, ';');
-        id = stoi(line);
-        getline(edgeFile, line, ';');
-        n1 = stoi(line);
-        getline(edgeFile, line, '\n');
-        n2 = stoi(line);
 
+    TextParser edgeFile("../resources/mapa1/arestas.txt");
+    int n1, n2;
+    while (edgeFile.next(id) && edgeFile.next(n1) && edgeFile.next(n2))
         gv->addEdge(id, n1, n2, EdgeType::UNDIRECTED);
-    }
 }
 
 int main() {
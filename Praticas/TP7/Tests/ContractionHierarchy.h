@@ -0,0 +1,403 @@
+/*
+ * ContractionHierarchy.h
+ * Contraction hierarchy over a Graph, for fast point-to-point shortest path
+ * queries on static graphs (e.g. road maps).
+ */
+
+#ifndef CONTRACTIONHIERARCHY_H_
+#define CONTRACTIONHIERARCHY_H_
+
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include "Graph.h"
+
+using namespace std;
+
+/*
+ * Preprocessing contracts the vertices one by one, in order of increasing
+ * edge difference (shortcuts added minus edges removed, plus the number of
+ * neighbours already contracted, to spread the contraction evenly).
+ * Contracting v adds a shortcut u->x for each pair of edges u->v, v->x
+ * unless a local search (witness search) finds a path from u to x, avoiding v,
+ * that is not longer.
+ *
+ * All edges and shortcuts are then split in an upward graph (edges to vertices
+ * contracted later) and a reversed downward graph, both stored in CSR form
+ * (see FrozenGraph.h). A query is a bidirectional Dijkstra that only goes up
+ * in both directions; shortcuts are unpacked recursively to obtain the path.
+ */
+template <class T>
+class ContractionHierarchy {
+	struct Arc {
+		int to;
+		double weight;
+		int mid;         // vertex contracted to create this shortcut, -1 for an original edge
+	};
+
+	FrozenGraph<T> graph;    // original graph, for vertex ids and contents
+	vector<int> rank;        // contraction order, by vertex id
+	int shortcuts = 0;
+
+	// upArcs[upOffsets[v] .. upOffsets[v+1]-1]: arcs v->to with rank[to] > rank[v]
+	// downArcs[downOffsets[v] .. downOffsets[v+1]-1]: arcs to->v with rank[to] > rank[v]
+	vector<int> upOffsets, downOffsets;
+	vector<Arc> upArcs, downArcs;
+
+	// query state; only the entries in "touched" are reset between queries
+	vector<double> distF, distB;
+	vector<int> predF, predB;
+	vector<int> touched;
+	int settled = 0;
+
+	// preprocessing state
+	vector<vector<Arc>> out, in;
+	vector<bool> contracted;
+	vector<int> contractedNeighbours;
+	vector<double> witnessDist;
+	vector<int> witnessTouched;
+
+	static const int WITNESS_SETTLE_LIMIT = 500;
+
+	void addArc(int u, int x, double w, int mid);
+	void witnessSearch(int u, int avoid, double maxDist);
+	int contract(int v, bool simulate);
+	int priority(int v);
+	void buildSearchGraphs();
+
+	int query(int s, int t);
+	const Arc &findArc(const vector<int> &offsets, const vector<Arc> &arcs, int v, int to) const;
+	void unpack(int a, int b, int mid, vector<T> &res) const;
+
+public:
+	explicit ContractionHierarchy(const Graph<T> &g);
+	int getNumVertex() const;
+	int getNumShortcuts() const;
+	int getNumSettled() const;
+	double distance(const T &origin, const T &dest);
+	vector<T> shortestPath(const T &origin, const T &dest);
+};
+
+/**************** Preprocessing ************/
+
+template <class T>
+ContractionHierarchy<T>::ContractionHierarchy(const Graph<T> &g): graph(g.freeze()) {
+	int n = graph.getNumVertex();
+	out.assign(n, vector<Arc>());
+	in.assign(n, vector<Arc>());
+	contracted.assign(n, false);
+	contractedNeighbours.assign(n, 0);
+	witnessDist.assign(n, INF);
+	rank.assign(n, 0);
+	for (int v = 0; v < n; v++)
+		for (int e = graph.offsets[v]; e < graph.offsets[v + 1]; e++)
+			addArc(v, graph.targets[e], graph.weights[e], -1);
+
+	// contract by priority, updating priorities lazily when extracted
+	priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> q;
+	for (int v = 0; v < n; v++)
+		q.push(make_pair(priority(v), v));
+	int order = 0;
+	while ( ! q.empty() ) {
+		int v = q.top().second;
+		q.pop();
+		int p = priority(v);
+		if ( ! q.empty() && p > q.top().first) {
+			q.push(make_pair(p, v));
+			continue;
+		}
+		shortcuts += contract(v, false);
+		contracted[v] = true;
+		rank[v] = order++;
+		for (auto &a : out[v])
+			contractedNeighbours[a.to]++;
+		for (auto &a : in[v])
+			contractedNeighbours[a.to]++;
+	}
+
+	buildSearchGraphs();
+	out.clear();
+	in.clear();
+	witnessDist.clear();
+
+	distF.assign(n, INF);
+	distB.assign(n, INF);
+	predF.assign(n, -1);
+	predB.assign(n, -1);
+}
+
+/*
+ * Adds the arc u->x, or decreases the weight of an existing one.
+ * Self loops are ignored.
+ */
+template <class T>
+void ContractionHierarchy<T>::addArc(int u, int x, double w, int mid) {
+	if (u == x)
+		return;
+	for (auto &a : out[u])
+		if (a.to == x) {
+			if (w < a.weight) {
+				a.weight = w;
+				a.mid = mid;
+				for (auto &b : in[x])
+					if (b.to == u) {
+						b.weight = w;
+						b.mid = mid;
+					}
+			}
+			return;
+		}
+	out[u].push_back(Arc{x, w, mid});
+	in[x].push_back(Arc{u, w, mid});
+}
+
+/*
+ * Dijkstra from u over the vertices not yet contracted, except "avoid",
+ * up to distance maxDist or WITNESS_SETTLE_LIMIT settled vertices.
+ * Leaves the distances in witnessDist (reset by the next search).
+ */
+template <class T>
+void ContractionHierarchy<T>::witnessSearch(int u, int avoid, double maxDist) {
+	for (int v : witnessTouched)
+		witnessDist[v] = INF;
+	witnessTouched.clear();
+	priority_queue<pair<double, int>, vector<pair<double, int>>, greater<pair<double, int>>> q;
+	witnessDist[u] = 0;
+	witnessTouched.push_back(u);
+	q.push(make_pair(0.0, u));
+	int count = 0;
+	while ( ! q.empty() && q.top().first <= maxDist && count < WITNESS_SETTLE_LIMIT) {
+		double d = q.top().first;
+		int v = q.top().second;
+		q.pop();
+		if (d > witnessDist[v])
+			continue; // stale entry
+		count++;
+		for (auto &a : out[v]) {
+			if (contracted[a.to] || a.to == avoid)
+				continue;
+			if (d + a.weight < witnessDist[a.to]) {
+				if (witnessDist[a.to] == INF)
+					witnessTouched.push_back(a.to);
+				witnessDist[a.to] = d + a.weight;
+				q.push(make_pair(witnessDist[a.to], a.to));
+			}
+		}
+	}
+}
+
+/*
+ * Contracts vertex v (or only counts the shortcuts needed, if simulate).
+ * Returns the number of shortcuts.
+ */
+template <class T>
+int ContractionHierarchy<T>::contract(int v, bool simulate) {
+	int count = 0;
+	for (unsigned i = 0; i < in[v].size(); i++) {
+		Arc a = in[v][i];
+		if (contracted[a.to])
+			continue;
+		double maxDist = -1;
+		for (auto &b : out[v])
+			if ( ! contracted[b.to] && b.to != a.to)
+				maxDist = max(maxDist, a.weight + b.weight);
+		if (maxDist < 0)
+			continue;
+		witnessSearch(a.to, v, maxDist);
+		for (unsigned j = 0; j < out[v].size(); j++) {
+			Arc b = out[v][j];
+			if (contracted[b.to] || b.to == a.to || witnessDist[b.to] <= a.weight + b.weight)
+				continue;
+			count++;
+			if ( ! simulate)
+				addArc(a.to, b.to, a.weight + b.weight, v);
+		}
+	}
+	return count;
+}
+
+template <class T>
+int ContractionHierarchy<T>::priority(int v) {
+	int removed = 0;
+	for (auto &a : out[v])
+		if ( ! contracted[a.to])
+			removed++;
+	for (auto &a : in[v])
+		if ( ! contracted[a.to])
+			removed++;
+	return contract(v, true) - removed + contractedNeighbours[v];
+}
+
+template <class T>
+void ContractionHierarchy<T>::buildSearchGraphs() {
+	int n = graph.getNumVertex();
+	upOffsets.assign(n + 1, 0);
+	downOffsets.assign(n + 1, 0);
+	for (int v = 0; v < n; v++)
+		for (auto &a : out[v]) {
+			if (rank[a.to] > rank[v])
+				upOffsets[v + 1]++;
+			else
+				downOffsets[a.to + 1]++;
+		}
+	for (int v = 0; v < n; v++) {
+		upOffsets[v + 1] += upOffsets[v];
+		downOffsets[v + 1] += downOffsets[v];
+	}
+	upArcs.resize(upOffsets[n]);
+	downArcs.resize(downOffsets[n]);
+	vector<int> upPos(upOffsets.begin(), upOffsets.end() - 1);
+	vector<int> downPos(downOffsets.begin(), downOffsets.end() - 1);
+	for (int v = 0; v < n; v++)
+		for (auto &a : out[v]) {
+			if (rank[a.to] > rank[v])
+				upArcs[upPos[v]++] = a;
+			else
+				downArcs[downPos[a.to]++] = Arc{v, a.weight, a.mid};
+		}
+}
+
+/**************** Queries ************/
+
+template <class T>
+int ContractionHierarchy<T>::getNumVertex() const {
+	return graph.getNumVertex();
+}
+
+template <class T>
+int ContractionHierarchy<T>::getNumShortcuts() const {
+	return shortcuts;
+}
+
+/*
+ * Number of vertices settled by the last query (in both directions).
+ */
+template <class T>
+int ContractionHierarchy<T>::getNumSettled() const {
+	return settled;
+}
+
+/*
+ * Bidirectional upward search between vertex ids s and t.
+ * Each direction stops when its smallest key reaches the best distance found.
+ * Returns the vertex where the searches meet on a shortest path (-1 if none).
+ */
+template <class T>
+int ContractionHierarchy<T>::query(int s, int t) {
+	typedef pair<double, int> Entry;
+	for (int v : touched) {
+		distF[v] = distB[v] = INF;
+		predF[v] = predB[v] = -1;
+	}
+	touched.clear();
+	settled = 0;
+	distF[s] = 0;
+	distB[t] = 0;
+	touched.push_back(s);
+	touched.push_back(t);
+
+	priority_queue<Entry, vector<Entry>, greater<Entry>> qf, qb;
+	qf.push(Entry(0, s));
+	qb.push(Entry(0, t));
+	double best = INF;
+	int meet = -1;
+	while (true) {
+		bool forward = ! qf.empty() && qf.top().first < best;
+		bool backward = ! qb.empty() && qb.top().first < best;
+		if ( ! forward && ! backward)
+			break;
+		if (forward && backward)
+			forward = qf.top().first <= qb.top().first;
+		auto &q = forward ? qf : qb;
+		auto &dist = forward ? distF : distB;
+		auto &pred = forward ? predF : predB;
+		auto &other = forward ? distB : distF;
+		auto &offsets = forward ? upOffsets : downOffsets;
+		auto &arcs = forward ? upArcs : downArcs;
+
+		double d = q.top().first;
+		int v = q.top().second;
+		q.pop();
+		if (d > dist[v])
+			continue; // stale entry
+		settled++;
+		if (other[v] != INF && d + other[v] < best) {
+			best = d + other[v];
+			meet = v;
+		}
+		for (int i = offsets[v]; i < offsets[v + 1]; i++) {
+			int w = arcs[i].to;
+			if (d + arcs[i].weight < dist[w]) {
+				if (distF[w] == INF && distB[w] == INF)
+					touched.push_back(w);
+				dist[w] = d + arcs[i].weight;
+				pred[w] = v;
+				q.push(Entry(dist[w], w));
+			}
+		}
+	}
+	return meet;
+}
+
+template <class T>
+double ContractionHierarchy<T>::distance(const T &origin, const T &dest) {
+	int s = graph.findVertexId(origin), t = graph.findVertexId(dest);
+	if (s == -1 || t == -1)
+		return INF;
+	int meet = query(s, t);
+	return meet == -1 ? INF : distF[meet] + distB[meet];
+}
+
+/*
+ * Finds the arc of vertex v (in the given CSR graph) whose other end is "to".
+ */
+template <class T>
+const typename ContractionHierarchy<T>::Arc &ContractionHierarchy<T>::findArc(
+		const vector<int> &offsets, const vector<Arc> &arcs, int v, int to) const {
+	int i = offsets[v];
+	while (arcs[i].to != to)
+		i++;
+	return arcs[i];
+}
+
+/*
+ * Appends to res the vertices of the arc a->b, except a, replacing shortcuts
+ * by the two arcs a->mid and mid->b they were made of (recursively).
+ * Since mid was contracted before a and b, a->mid is in the downward graph
+ * of mid and mid->b is in the upward graph of mid.
+ */
+template <class T>
+void ContractionHierarchy<T>::unpack(int a, int b, int mid, vector<T> &res) const {
+	if (mid == -1) {
+		res.push_back(graph.info[b]);
+		return;
+	}
+	unpack(a, mid, findArc(downOffsets, downArcs, mid, a).mid, res);
+	unpack(mid, b, findArc(upOffsets, upArcs, mid, b).mid, res);
+}
+
+/*
+ * Returns the shortest path from origin to dest (empty if missing or disconnected).
+ */
+template <class T>
+vector<T> ContractionHierarchy<T>::shortestPath(const T &origin, const T &dest) {
+	vector<T> res;
+	int s = graph.findVertexId(origin), t = graph.findVertexId(dest);
+	if (s == -1 || t == -1)
+		return res;
+	int meet = query(s, t);
+	if (meet == -1)
+		return res;
+
+	vector<int> up; // meet, ..., s
+	for (int v = meet; v != -1; v = predF[v])
+		up.push_back(v);
+	res.push_back(graph.info[s]);
+	for (int i = up.size() - 1; i > 0; i--)
+		unpack(up[i], up[i - 1], findArc(upOffsets, upArcs, up[i], up[i - 1]).mid, res);
+	for (int v = meet; v != t; v = predB[v])
+		unpack(v, predB[v], findArc(downOffsets, downArcs, predB[v], v).mid, res);
+	return res;
+}
+
+#endif /* CONTRACTIONHIERARCHY_H_ */
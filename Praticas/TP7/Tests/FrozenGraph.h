@@ -0,0 +1,629 @@
+/*
+ * FrozenGraph.h
+ * Immutable compressed sparse row (CSR) snapshot of a Graph, for read-only
+ * shortest path queries. Obtained with Graph<T>::freeze().
+ */
+
+#ifndef FROZENGRAPH_H_
+#define FROZENGRAPH_H_
+
+#include <vector>
+#include <queue>
+#include <limits>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+template <class T> class Graph;
+template <class T> class ContractionHierarchy;
+class MappedGraph;
+
+#ifndef INF
+#define INF std::numeric_limits<double>::max()
+#endif
+
+/*
+ * Reusable barrier for a fixed number of threads: wait() blocks until all of
+ * them have called it.
+ */
+class Barrier {
+	mutex m;
+	condition_variable cv;
+	unsigned count, waiting = 0, generation = 0;
+public:
+	explicit Barrier(unsigned count) : count(count) {}
+	void wait() {
+		unique_lock<mutex> lock(m);
+		unsigned gen = generation;
+		if (++waiting == count) {
+			waiting = 0;
+			generation++;
+			cv.notify_all();
+		}
+		else
+			cv.wait(lock, [&] { return gen != generation; });
+	}
+};
+
+/*
+ * Labels of a single source search (dist, path) over a FrozenGraph, in dense
+ * arrays indexed by vertex id, plus the auxiliary queue of the search.
+ * A query only modifies the context it is given, so several threads can query
+ * the same graph at once, each with its own context.
+ * Labels are reset lazily: an entry whose stamp is not the current generation
+ * is unset (dist INF, no path), so starting a new search is O(1).
+ */
+class SearchContext {
+	vector<double> dist;
+	vector<int> path;
+	vector<unsigned> stamp;
+	unsigned generation = 0;
+	vector<pair<double, int>> heap;   // reused by each search, to avoid allocations
+	vector<int> fifo;
+	vector<int> cycle;                // negative cycle found by the search, if any
+
+	template <class T> friend class FrozenGraph;
+	friend class MappedGraph;
+public:
+	/*
+	 * Starts a new search over a graph with n vertices.
+	 */
+	void reset(int n) {
+		if ((int) stamp.size() != n || ++generation == 0) {
+			dist.assign(n, INF);
+			path.assign(n, -1);
+			stamp.assign(n, 0);
+			generation = 1;
+		}
+		heap.clear();
+		fifo.clear();
+		cycle.clear();
+	}
+	bool empty() const {
+		return generation == 0;
+	}
+	double getDist(int v) const {
+		return stamp[v] == generation ? dist[v] : INF;
+	}
+	int getPath(int v) const {
+		return stamp[v] == generation ? path[v] : -1;
+	}
+	void set(int v, double d, int p) {
+		stamp[v] = generation;
+		dist[v] = d;
+		path[v] = p;
+	}
+};
+
+/*
+ * Vertices are identified by dense integer ids (0..n-1), given by their
+ * position in the vertexSet of the original graph. The outgoing edges of
+ * vertex i are stored, contiguously, in positions [offsets[i], offsets[i+1])
+ * of the targets and weights arrays.
+ *
+ * Queries taking a SearchContext do not modify the graph and can run
+ * concurrently; the others store their results in the graph, like Graph does.
+ */
+template <class T>
+class FrozenGraph {
+	vector<T> info;            // contents, by vertex id
+	vector<int> offsets;       // first edge of each vertex (size n+1)
+	vector<int> targets;       // destination vertex id, by edge
+	vector<double> weights;    // edge weight, by edge
+	unordered_map<T, int, function<size_t(const T &)>> idIndex; // optional, see Graph::setHasher
+	bool indexed = false;
+
+	SearchContext last;        // results of the last query without context
+
+	FrozenGraph() = default;
+	int initSingleSource(const T &origin, SearchContext &ctx) const;
+	bool relax(int v, int w, double weight, SearchContext &ctx) const;
+	template <class Parent> bool findParentCycle(Parent parent, vector<int> &cycle) const;
+	bool bellmanFordFrom(const vector<int> &sources, SearchContext &ctx, bool queue, int numThreads) const;
+
+public:
+	int getNumVertex() const;
+	int getNumEdges() const;
+	int findVertexId(const T &in) const;
+	T getInfo(int id) const;
+	double getDist(int id) const;
+	int getPathId(int id) const;
+
+	void dijkstraShortestPath(const T &s);
+	void unweightedShortestPath(const T &s);
+	bool bellmanFordShortestPath(const T &s, bool queue = false, int numThreads = 1);
+	void deltaSteppingShortestPath(const T &s, double delta, int numThreads = 1);
+	vector<T> getPath(const T &origin, const T &dest) const;
+	vector<T> getNegativeCycle() const;
+
+	void dijkstraShortestPath(const T &s, SearchContext &ctx) const;
+	void unweightedShortestPath(const T &s, SearchContext &ctx) const;
+	bool bellmanFordShortestPath(const T &s, SearchContext &ctx, bool queue = false, int numThreads = 1) const;
+	void deltaSteppingShortestPath(const T &s, double delta, int numThreads, SearchContext &ctx) const;
+	vector<T> getPath(const T &origin, const T &dest, const SearchContext &ctx) const;
+	vector<T> getNegativeCycle(const SearchContext &ctx) const;
+
+	friend class Graph<T>;
+	friend class ContractionHierarchy<T>;
+	friend class MappedGraph;
+};
+
+template <class T>
+int FrozenGraph<T>::getNumVertex() const {
+	return info.size();
+}
+
+template <class T>
+int FrozenGraph<T>::getNumEdges() const {
+	return targets.size();
+}
+
+/*
+ * Finds the id of the vertex with a given content, or -1 if there is none.
+ */
+template <class T>
+int FrozenGraph<T>::findVertexId(const T &in) const {
+	if (indexed) {
+		auto it = idIndex.find(in);
+		return it == idIndex.end() ? -1 : it->second;
+	}
+	for (unsigned i = 0; i < info.size(); i++)
+		if (info[i] == in)
+			return i;
+	return -1;
+}
+
+template <class T>
+T FrozenGraph<T>::getInfo(int id) const {
+	return info[id];
+}
+
+template <class T>
+double FrozenGraph<T>::getDist(int id) const {
+	return last.getDist(id);
+}
+
+/*
+ * Returns the id of the predecessor of a vertex in the last shortest path
+ * query, or -1 if the vertex is the source or was not reached.
+ */
+template <class T>
+int FrozenGraph<T>::getPathId(int id) const {
+	return last.getPath(id);
+}
+
+/**************** Single Source Shortest Path algorithms ************/
+
+/**
+ * Same as Graph<T>::initSingleSource, but returns the id of the source vertex,
+ * or -1 if it is not in the graph (ctx is then left with no vertex reached).
+ */
+template <class T>
+int FrozenGraph<T>::initSingleSource(const T &origin, SearchContext &ctx) const {
+	ctx.reset(info.size());
+	int s = findVertexId(origin);
+	if (s == -1)
+		return -1;
+	ctx.set(s, 0, -1);
+	return s;
+}
+
+template <class T>
+inline bool FrozenGraph<T>::relax(int v, int w, double weight, SearchContext &ctx) const {
+	double d = ctx.getDist(v) + weight;
+	if (d < ctx.getDist(w)) {
+		ctx.set(w, d, v);
+		return true;
+	}
+	else
+		return false;
+}
+
+template <class T>
+void FrozenGraph<T>::dijkstraShortestPath(const T &origin) {
+	dijkstraShortestPath(origin, last);
+}
+
+template <class T>
+void FrozenGraph<T>::unweightedShortestPath(const T &orig) {
+	unweightedShortestPath(orig, last);
+}
+
+template <class T>
+bool FrozenGraph<T>::bellmanFordShortestPath(const T &orig, bool queue, int numThreads) {
+	return bellmanFordShortestPath(orig, last, queue, numThreads);
+}
+
+template <class T>
+void FrozenGraph<T>::deltaSteppingShortestPath(const T &orig, double delta, int numThreads) {
+	deltaSteppingShortestPath(orig, delta, numThreads, last);
+}
+
+template <class T>
+vector<T> FrozenGraph<T>::getPath(const T &origin, const T &dest) const {
+	return getPath(origin, dest, last);
+}
+
+template <class T>
+vector<T> FrozenGraph<T>::getNegativeCycle() const {
+	return getNegativeCycle(last);
+}
+
+/*
+ * Uses a binary heap with lazy deletion: instead of decreasing the key of a
+ * vertex already in the queue, a new entry is pushed and the old one is
+ * skipped when extracted.
+ */
+template <class T>
+void FrozenGraph<T>::dijkstraShortestPath(const T &origin, SearchContext &ctx) const {
+	int s = initSingleSource(origin, ctx);
+	if (s == -1)
+		return;
+	auto &q = ctx.heap;
+	auto cmp = greater<pair<double, int>>();
+	q.push_back(make_pair(0.0, s));
+	while( ! q.empty() ) {
+		pop_heap(q.begin(), q.end(), cmp);
+		auto top = q.back();
+		q.pop_back();
+		int v = top.second;
+		if (top.first > ctx.getDist(v))
+			continue; // stale entry
+		for (int e = offsets[v]; e < offsets[v + 1]; e++)
+			if (relax(v, targets[e], weights[e], ctx)) {
+				q.push_back(make_pair(ctx.getDist(targets[e]), targets[e]));
+				push_heap(q.begin(), q.end(), cmp);
+			}
+	}
+}
+
+template <class T>
+void FrozenGraph<T>::unweightedShortestPath(const T &orig, SearchContext &ctx) const {
+	int s = initSingleSource(orig, ctx);
+	if (s == -1)
+		return;
+	auto &q = ctx.fifo;
+	q.push_back(s);
+	for (unsigned head = 0; head < q.size(); head++) {
+		int v = q[head];
+		for (int e = offsets[v]; e < offsets[v + 1]; e++)
+			if (relax(v, targets[e], 1, ctx))
+				q.push_back(targets[e]);
+	}
+}
+
+/*
+ * Looks for a cycle in the shortest path tree given by parent (the
+ * predecessor of each vertex, or -1). Such a cycle only appears when there is
+ * a negative cycle, and is then always negative. Returns it in cycle, in the
+ * order of its edges.
+ */
+template <class T>
+template <class Parent>
+bool FrozenGraph<T>::findParentCycle(Parent parent, vector<int> &cycle) const {
+	int n = info.size();
+	vector<int> walk(n, -1); // first walk that reached each vertex
+	for (int s = 0; s < n; s++) {
+		int v = s;
+		while (v != -1 && walk[v] == -1) {
+			walk[v] = s;
+			v = parent(v);
+		}
+		if (v != -1 && walk[v] == s) {
+			cycle.clear();
+			int u = v;
+			do {
+				cycle.push_back(u);
+				u = parent(u);
+			} while (u != v);
+			reverse(cycle.begin(), cycle.end());
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+ * Bellman-Ford, stopping as soon as a round relaxes no edge.
+ * With queue, only the outgoing edges of the vertices whose distance changed
+ * are relaxed (SPFA); a vertex relaxed n times shows a negative cycle.
+ * Otherwise, with more than one thread, each round computes the new distance
+ * of every vertex from the distances of the previous round (so the result
+ * does not depend on the order of the edges), and the vertices are split
+ * across numThreads threads; with one thread, edges are relaxed in place.
+ * Returns false if a negative cycle is reachable from the source; the cycle
+ * can then be obtained with getNegativeCycle. The distances are not final.
+ * Also returns false (with no cycle) if orig is not in the graph.
+ */
+template <class T>
+bool FrozenGraph<T>::bellmanFordShortestPath(const T &orig, SearchContext &ctx, bool queue, int numThreads) const {
+	int s = initSingleSource(orig, ctx);
+	if (s == -1)
+		return false;
+	return bellmanFordFrom(vector<int>(1, s), ctx, queue, numThreads);
+}
+
+/*
+ * Bellman-Ford from several sources at once, all at distance 0 (as from a
+ * virtual source with an edge of weight 0 to each of them), with ctx already
+ * reset and the sources set in it. See bellmanFordShortestPath.
+ */
+template <class T>
+bool FrozenGraph<T>::bellmanFordFrom(const vector<int> &sources, SearchContext &ctx, bool queue, int numThreads) const {
+	int n = info.size();
+	auto ctxParent = [&ctx](int v) { return ctx.getPath(v); };
+
+	if (queue) {
+		vector<char> inQueue(n, 0);
+		vector<int> count(n, 0); // times each vertex was relaxed
+		std::queue<int> q;
+		for (int s : sources) {
+			q.push(s);
+			inQueue[s] = 1;
+		}
+		while ( ! q.empty() ) {
+			int v = q.front();
+			q.pop();
+			inQueue[v] = 0;
+			for (int e = offsets[v]; e < offsets[v + 1]; e++) {
+				int w = targets[e];
+				if (relax(v, w, weights[e], ctx)) {
+					if (++count[w] % n == 0 && findParentCycle(ctxParent, ctx.cycle))
+						return false;
+					if (!inQueue[w]) {
+						inQueue[w] = 1;
+						q.push(w);
+					}
+				}
+			}
+		}
+		return true;
+	}
+
+	if (numThreads <= 1) {
+		for (int round = 1; ; round++) {
+			bool changed = false;
+			for (int v = 0; v < n; v++)
+				for (int e = offsets[v]; e < offsets[v + 1]; e++)
+					changed = relax(v, targets[e], weights[e], ctx) || changed;
+			if (!changed)
+				return true;
+			if (round >= n && findParentCycle(ctxParent, ctx.cycle))
+				return false;
+		}
+	}
+
+	// incoming edges, to compute each vertex from its predecessors
+	vector<int> inOffsets(n + 1, 0), inSources(targets.size());
+	vector<double> inWeights(targets.size());
+	for (int w : targets)
+		inOffsets[w + 1]++;
+	for (int v = 0; v < n; v++)
+		inOffsets[v + 1] += inOffsets[v];
+	vector<int> next(inOffsets.begin(), inOffsets.end() - 1);
+	for (int v = 0; v < n; v++)
+		for (int e = offsets[v]; e < offsets[v + 1]; e++) {
+			inSources[next[targets[e]]] = v;
+			inWeights[next[targets[e]]++] = weights[e];
+		}
+
+	vector<double> dist(n, INF), newDist(n);
+	vector<int> path(n, -1), newPath(n);
+	for (int s : sources)
+		dist[s] = 0;
+	unsigned nt = min(numThreads, max(n, 1));
+	vector<char> changed(nt);
+	bool stop = false, cycle = false;
+	Barrier barrier(nt);
+	auto work = [&](unsigned t) {
+		for (int round = 1; ; round++) {
+			changed[t] = 0;
+			for (int w = (long) n * t / nt; w < (long) n * (t + 1) / nt; w++) {
+				newDist[w] = dist[w];
+				newPath[w] = path[w];
+				for (int e = inOffsets[w]; e < inOffsets[w + 1]; e++)
+					if (dist[inSources[e]] + inWeights[e] < newDist[w]) {
+						newDist[w] = dist[inSources[e]] + inWeights[e];
+						newPath[w] = inSources[e];
+						changed[t] = 1;
+					}
+			}
+			barrier.wait();
+			if (t == 0) {
+				dist.swap(newDist);
+				path.swap(newPath);
+				stop = find(changed.begin(), changed.end(), 1) == changed.end();
+				if (!stop && round >= n) {
+					cycle = findParentCycle([&path](int v) { return path[v]; }, ctx.cycle);
+					stop = cycle;
+				}
+			}
+			barrier.wait();
+			if (stop)
+				return;
+		}
+	};
+	vector<thread> threads;
+	for (unsigned t = 0; t < nt; t++)
+		threads.push_back(thread(work, t));
+	for (auto &t : threads)
+		t.join();
+	for (int v = 0; v < n; v++)
+		if (dist[v] != INF)
+			ctx.set(v, dist[v], path[v]);
+	return !cycle;
+}
+
+/*
+ * Delta-stepping (Meyer and Sanders): vertices are kept in buckets of width
+ * delta by tentative distance, and all the vertices of the first non empty
+ * bucket are relaxed at once. Light edges (weight <= delta) may put vertices
+ * back in the current bucket, so they are relaxed until the bucket stays
+ * empty; heavy edges are relaxed once, from the vertices removed from it.
+ * With delta -> 0 it behaves like Dijkstra, with delta -> INF like
+ * Bellman-Ford. delta must be positive and edge weights not negative.
+ *
+ * Each of the numThreads workers owns the vertices v with v % numThreads == t:
+ * only the owner changes their labels or bucket entries. A worker relaxes the
+ * edges of its own vertices into relaxation requests, buffered by the owner
+ * of the target, and then applies the requests addressed to it. Buckets are
+ * circular, as no entry can be more than maxWeight / delta buckets ahead of
+ * the current one.
+ */
+template <class T>
+void FrozenGraph<T>::deltaSteppingShortestPath(const T &orig, double delta, int numThreads, SearchContext &ctx) const {
+	struct Request {
+		int v, w;     // edge (v, w)
+		double dist;  // dist(v) + weight(v, w)
+	};
+	int s = initSingleSource(orig, ctx);
+	if (s == -1)
+		return;
+	unsigned n = info.size(), nt = max(numThreads, 1);
+	double maxWeight = 0;
+	for (double w : weights)
+		maxWeight = max(maxWeight, w);
+	unsigned numBuckets = (unsigned) (maxWeight / delta) + 2;
+	auto bucketOf = [delta](double d) { return (size_t) (d / delta); };
+
+	vector<vector<vector<int>>> buckets(nt, vector<vector<int>>(numBuckets)); // by owner, by bucket
+	vector<long> pending(nt, 0);                       // bucket entries, by owner
+	vector<vector<vector<Request>>> requests(nt, vector<vector<Request>>(nt)); // by worker, by owner
+	vector<vector<int>> frontier(nt), removed(nt);     // by owner
+	vector<char> active(nt, 0);                        // frontier not empty, by owner
+	vector<size_t> inFrontier(n, 0), inRemoved(n, 0);  // last round/bucket (+1) the vertex was in them
+	buckets[s % nt][0].push_back(s);
+	pending[s % nt] = 1;
+	size_t current = 0;
+	bool done = false;
+	Barrier barrier(nt);
+
+	auto work = [&](unsigned t) {
+		size_t round = 0;
+		// relaxes the given edges of the vertices in from, into requests
+		auto generate = [&](const vector<int> &from, bool light) {
+			for (int v : from)
+				for (int e = offsets[v]; e < offsets[v + 1]; e++)
+					if ((weights[e] <= delta) == light)
+						requests[t][targets[e] % nt].push_back({v, targets[e], ctx.getDist(v) + weights[e]});
+		};
+		// applies the requests addressed to this worker
+		auto apply = [&]() {
+			for (unsigned p = 0; p < nt; p++) {
+				for (auto &r : requests[p][t])
+					if (r.dist < ctx.getDist(r.w)) {
+						ctx.set(r.w, r.dist, r.v);
+						buckets[t][bucketOf(r.dist) % numBuckets].push_back(r.w);
+						pending[t]++;
+					}
+				requests[p][t].clear();
+			}
+		};
+		while (true) {
+			// worker 0 finds the next non empty bucket
+			barrier.wait();
+			if (t == 0) {
+				long total = 0;
+				for (long c : pending)
+					total += c;
+				done = total == 0;
+				while (!done) {
+					bool empty = true;
+					for (unsigned o = 0; o < nt && empty; o++)
+						empty = buckets[o][current % numBuckets].empty();
+					if (!empty)
+						break;
+					current++;
+				}
+			}
+			barrier.wait();
+			if (done)
+				return;
+			size_t i = current;
+			auto &bucket = buckets[t][i % numBuckets];
+			while (true) {
+				// remove own vertices of bucket i (skipping stale and repeated entries)
+				round++;
+				frontier[t].clear();
+				pending[t] -= bucket.size();
+				for (int v : bucket)
+					if (bucketOf(ctx.getDist(v)) == i && inFrontier[v] != round) {
+						inFrontier[v] = round;
+						frontier[t].push_back(v);
+						if (inRemoved[v] != i + 1) {
+							inRemoved[v] = i + 1;
+							removed[t].push_back(v);
+						}
+					}
+				bucket.clear();
+				active[t] = !frontier[t].empty();
+				barrier.wait();
+				bool any = false;
+				for (unsigned o = 0; o < nt; o++)
+					any = any || active[o];
+				if (!any)
+					break;
+				generate(frontier[t], true);
+				barrier.wait();
+				apply();
+				barrier.wait();
+			}
+			generate(removed[t], false);
+			removed[t].clear();
+			barrier.wait();
+			apply();
+			if (t == 0)
+				current++;
+		}
+	};
+
+	if (nt == 1) {
+		work(0);
+		return;
+	}
+	vector<thread> threads;
+	for (unsigned t = 0; t < nt; t++)
+		threads.push_back(thread(work, t));
+	for (auto &t : threads)
+		t.join();
+}
+
+/*
+ * Path from origin to dest found by the last search in ctx. Empty if dest was
+ * not reached, or if that search did not start from origin.
+ */
+template <class T>
+vector<T> FrozenGraph<T>::getPath(const T &origin, const T &dest, const SearchContext &ctx) const {
+	vector<T> res;
+	int v = findVertexId(dest);
+	if (v == -1 || ctx.empty() || ctx.getDist(v) == INF) // missing, not computed or disconnected
+		return res;
+	int root = v;
+	for ( ; v != -1; v = ctx.getPath(v)) {
+		res.push_back(info[v]);
+		root = v;
+	}
+	if (root != findVertexId(origin))
+		return vector<T>();
+	reverse(res.begin(), res.end());
+	return res;
+}
+
+/*
+ * Negative cycle found by the last Bellman-Ford search, in the order of its
+ * edges (the first vertex is not repeated at the end); empty if there is none.
+ */
+template <class T>
+vector<T> FrozenGraph<T>::getNegativeCycle(const SearchContext &ctx) const {
+	vector<T> res;
+	for (int v : ctx.cycle)
+		res.push_back(info[v]);
+	return res;
+}
+
+#endif /* FROZENGRAPH_H_ */
@@ -7,15 +7,22 @@
 #include <vector>
 #include <queue>
 #include <limits>
+#include <unordered_map>
+#include <functional>
 #include <algorithm>
+#include <cmath>
 #include <unordered_set>
+#include <thread>
+#include <atomic>
 #include "MutablePriorityQueue.h"
+#include "FrozenGraph.h"
 
 using namespace std;
 
 template <class T> class Edge;
 template <class T> class Graph;
 template <class T> class Vertex;
+template <class T> class GraphBuilder;
 
 #define INF std::numeric_limits<double>::max()
 
@@ -29,6 +36,11 @@ class Vertex {
 	double dist = 0;
 	Vertex<T> *path = nullptr;
 	int queueIndex = 0; 		// required by MutablePriorityQueue
+	double estimate = 0;        // A* estimate of the distance to the destination (0 otherwise)
+
+	vector<Edge<T> > incoming;  // incoming edges, built on demand by Graph::buildReverseAdjacency
+	double distR = 0;           // backward search fields, used by Graph::shortestPath
+	Vertex<T> *pathR = nullptr;
 
 	void addEdge(Vertex<T> *dest, double w);
 
@@ -39,8 +51,10 @@ public:
 	T getInfo() const;
 	double getDist() const;
 	Vertex *getPath() const;
+	vector<Edge<T>> getAdj() const;
 	friend class Graph<T>;
-	friend class MutablePriorityQueue<Vertex<T>>;
+	friend class GraphBuilder<T>;
+	template <class U, class Policy> friend class MutablePriorityQueue;
 };
 
 
@@ -58,7 +72,7 @@ void Vertex<T>::addEdge(Vertex<T> *d, double w) {
 
 template <class T>
 bool Vertex<T>::operator<(Vertex<T> & vertex) const {
-	return this->dist < vertex.dist;
+	return this->dist + this->estimate < vertex.dist + vertex.estimate;
 }
 
 template <class T>
@@ -76,6 +90,11 @@ Vertex<T> *Vertex<T>::getPath() const {
 	return this->path;
 }
 
+template <class T>
+vector<Edge<T>> Vertex<T>::getAdj() const {
+	return this->adj;
+}
+
 /********************** Edge  ****************************/
 
 template <class T>
@@ -93,6 +112,7 @@ public:
 
 	// Fp07
 	double getWeight() const;
+	Vertex<T> *getDest() const;
 };
 
 template <class T>
@@ -103,43 +123,68 @@ double Edge<T>::getWeight() const {
 	return weight;
 }
 
+template <class T>
+Vertex<T> *Edge<T>::getDest() const {
+	return dest;
+}
+
 
 /*************************** Graph  **************************/
 
 template <class T>
 class Graph {
 	vector<Vertex<T> *> vertexSet;    // vertex set
+	unordered_map<T, Vertex<T> *, function<size_t(const T &)>> vertexIndex; // optional, see setHasher
+	bool indexed = false;
 
 	// Fp05
 	Vertex<T> * initSingleSource(const T &orig);
 	bool relax(Vertex<T> *v, Vertex<T> *w, double weight);
-	double ** W = nullptr;   // dist
-	int **P = nullptr;   // path
+	vector<double> W;   // dist, n x n by rows
+	vector<int> P;      // path, n x n by rows
+	unsigned fwSize = 0;  // n when W and P were computed
+	int numThreads = 1;
 	int findVertexIdx(const T &in) const;
+	bool reverseValid = false;  // incoming edges are up to date
+	int settled = 0;            // vertices settled by the last point-to-point query
+	void buildReverseAdjacency();
+	vector<T> negativeCycle;    // found by the last Bellman-Ford search
+	void copySearch(const SearchContext &ctx);
 
 
 public:
+	void setHasher(function<size_t(const T &)> hasher);
 	Vertex<T> *findVertex(const T &in) const;
 	bool addVertex(const T &in);
 	bool addEdge(const T &sourc, const T &dest, double w);
 	int getNumVertex() const;
 	vector<Vertex<T> *> getVertexSet() const;
+	FrozenGraph<T> freeze() const;
 
 	// Fp05 - single source
-	void dijkstraShortestPath(const T &s);
+	template <class Q = MutablePriorityQueue<Vertex<T>>> void dijkstraShortestPath(const T &s);
 	void unweightedShortestPath(const T &s);
-	void bellmanFordShortestPath(const T &s);
+	bool bellmanFordShortestPath(const T &s, bool queue = false);
+	void deltaSteppingShortestPath(const T &s, double delta);
 	vector<T> getPath(const T &origin, const T &dest) const;
+	vector<T> getNegativeCycle() const;
+	vector<T> shortestPath(const T &origin, const T &dest);
+	template <class Q = MutablePriorityQueue<Vertex<T>>>
+	vector<T> aStarShortestPath(const T &origin, const T &dest, function<double(const T &, const T &)> heuristic);
+	int getNumSettled() const;
 
 	// Fp05 - all pairs
 	void floydWarshallShortestPath();
 	vector<T> getfloydWarshallPath(const T &origin, const T &dest) const;
-	~Graph();
+	bool johnsonAllPairs();
+	void setNumThreads(int num);
 
 	// Fp07 - minimum spanning tree
     bool addBidirectionalEdge(const T &sourc, const T &dest, double w);
-	vector<Vertex<T>*> calculatePrim();
+	template <class Q = MutablePriorityQueue<Vertex<T>>> vector<Vertex<T>*> calculatePrim();
 	vector<Vertex<T>*> calculateKruskal();
+
+	friend class GraphBuilder<T>;
 };
 
 
@@ -153,11 +198,28 @@ vector<Vertex<T> *> Graph<T>::getVertexSet() const {
 	return vertexSet;
 }
 
+/*
+ * Enables a hash index over the vertex contents, using the given hash function,
+ * so that findVertex runs in constant expected time instead of scanning vertexSet.
+ * Vertices already in the graph are indexed immediately.
+ */
+template <class T>
+void Graph<T>::setHasher(function<size_t(const T &)> hasher) {
+	vertexIndex = unordered_map<T, Vertex<T> *, function<size_t(const T &)>>(vertexSet.size(), hasher);
+	for (auto v : vertexSet)
+		vertexIndex.emplace(v->info, v);
+	indexed = true;
+}
+
 /*
  * Auxiliary function to find a vertex with a given content.
  */
 template <class T>
 Vertex<T> * Graph<T>::findVertex(const T &in) const {
+	if (indexed) {
+		auto it = vertexIndex.find(in);
+		return it == vertexIndex.end() ? nullptr : it->second;
+	}
 	for (auto v : vertexSet)
 		if (v->info == in)
 			return v;
@@ -183,6 +245,8 @@ bool Graph<T>::addVertex(const T &in) {
 	if (findVertex(in) != nullptr)
 		return false;
 	vertexSet.push_back(new Vertex<T>(in));
+	if (indexed)
+		vertexIndex.emplace(in, vertexSet.back());
 	return true;
 }
 
@@ -198,10 +262,45 @@ bool Graph<T>::addEdge(const T &sourc, const T &dest, double w) {
 	if (v1 == nullptr || v2 == nullptr)
 		return false;
 	v1->addEdge(v2, w);
+	reverseValid = false;
 	return true;
 }
 
 
+/*
+ * Builds an immutable CSR snapshot of the graph (see FrozenGraph.h).
+ * Vertex ids are the positions in vertexSet. Changes made to the graph
+ * afterwards are not reflected in the snapshot.
+ */
+template <class T>
+FrozenGraph<T> Graph<T>::freeze() const {
+	FrozenGraph<T> fg;
+	unsigned n = vertexSet.size();
+	unordered_map<Vertex<T> *, int> ids(n);
+	fg.info.reserve(n);
+	fg.offsets.reserve(n + 1);
+	fg.offsets.push_back(0);
+	for (unsigned i = 0; i < n; i++) {
+		ids[vertexSet[i]] = i;
+		fg.info.push_back(vertexSet[i]->info);
+		fg.offsets.push_back(fg.offsets.back() + vertexSet[i]->adj.size());
+	}
+	fg.targets.reserve(fg.offsets.back());
+	fg.weights.reserve(fg.offsets.back());
+	for (auto v : vertexSet)
+		for (auto &e : v->adj) {
+			fg.targets.push_back(ids[e.dest]);
+			fg.weights.push_back(e.weight);
+		}
+	if (indexed) {
+		fg.idIndex = unordered_map<T, int, function<size_t(const T &)>>(n, vertexIndex.hash_function());
+		for (unsigned i = 0; i < n; i++)
+			fg.idIndex.emplace(fg.info[i], i);
+		fg.indexed = true;
+	}
+	return fg;
+}
+
 /**************** Single Source Shortest Path algorithms ************/
 
 /**
@@ -214,6 +313,8 @@ Vertex<T> * Graph<T>::initSingleSource(const T &origin) {
 	for(auto v : vertexSet) {
 		v->dist = INF;
 		v->path = nullptr;
+		v->estimate = 0;
+		v->queueIndex = 0;
 	}
 	auto s = findVertex(origin);
 	s->dist = 0;
@@ -236,10 +337,15 @@ inline bool Graph<T>::relax(Vertex<T> *v, Vertex<T> *w, double weight) {
 		return false;
 }
 
+/*
+ * The priority queue implementation (Q) can be chosen by the caller,
+ * e.g. MutablePriorityQueue<Vertex<T>, DaryHeap<4>>; binary heap by default.
+ */
 template<class T>
+template<class Q>
 void Graph<T>::dijkstraShortestPath(const T &origin) {
 	auto s = initSingleSource(origin);
-	MutablePriorityQueue<Vertex<T>> q;
+	Q q;
 	q.insert(s);
 	while( ! q.empty() ) {
 		auto v = q.extractMin();
@@ -255,6 +361,10 @@ void Graph<T>::dijkstraShortestPath(const T &origin) {
 	}
 }
 
+/*
+ * Path to dest found by the last search, or an empty path if dest was not
+ * reached, or if that search did not start from origin.
+ */
 template<class T>
 vector<T> Graph<T>::getPath(const T &origin, const T &dest) const{
 	vector<T> res;
@@ -263,10 +373,153 @@ vector<T> Graph<T>::getPath(const T &origin, const T &dest) const{
 		return res;
 	for ( ; v != nullptr; v = v->path)
 		res.push_back(v->info);
+	if (!(res.back() == origin))
+		return vector<T>();
 	reverse(res.begin(), res.end());
 	return res;
 }
 
+/**
+ * Fills the incoming edges of every vertex, if edges were added since last time.
+ */
+template<class T>
+void Graph<T>::buildReverseAdjacency() {
+	if (reverseValid)
+		return;
+	for (auto v : vertexSet)
+		v->incoming.clear();
+	for (auto v : vertexSet)
+		for (auto &e : v->adj)
+			e.dest->incoming.push_back(e);
+	reverseValid = true;
+}
+
+/**
+ * Bidirectional Dijkstra for a single pair of vertices: searches forward from
+ * the origin (dist, path) and backward from the destination (distR, pathR),
+ * always expanding the side with the smallest key, and stops as soon as the
+ * sum of both keys reaches the best path found through a vertex reached by both.
+ * Afterwards dist/path along the returned path are consistent with getPath.
+ * Returns the path (empty if missing or disconnected).
+ */
+template<class T>
+vector<T> Graph<T>::shortestPath(const T &origin, const T &dest) {
+	typedef pair<double, Vertex<T> *> Entry;
+	auto s = findVertex(origin);
+	auto t = findVertex(dest);
+	settled = 0;
+	if (s == nullptr || t == nullptr)
+		return vector<T>();
+	buildReverseAdjacency();
+	for (auto v : vertexSet) {
+		v->dist = v->distR = INF;
+		v->path = v->pathR = nullptr;
+	}
+	s->dist = 0;
+	t->distR = 0;
+	double best = s == t ? 0 : INF;
+	Vertex<T> *meet = s == t ? s : nullptr;
+
+	priority_queue<Entry, vector<Entry>, greater<Entry>> qf, qb;
+	qf.push(Entry(0, s));
+	qb.push(Entry(0, t));
+	while ( ! qf.empty() && ! qb.empty() && qf.top().first + qb.top().first < best) {
+		if (qf.top().first <= qb.top().first) {
+			auto v = qf.top().second;
+			double d = qf.top().first;
+			qf.pop();
+			if (d > v->dist)
+				continue; // stale entry
+			settled++;
+			for (auto &e : v->adj) {
+				if (relax(v, e.dest, e.weight))
+					qf.push(Entry(e.dest->dist, e.dest));
+				if (e.dest->distR != INF && e.dest->dist + e.dest->distR < best) {
+					best = e.dest->dist + e.dest->distR;
+					meet = e.dest;
+				}
+			}
+		}
+		else {
+			auto v = qb.top().second;
+			double d = qb.top().first;
+			qb.pop();
+			if (d > v->distR)
+				continue; // stale entry
+			settled++;
+			for (auto &e : v->incoming) {
+				auto w = e.orig;
+				if (v->distR + e.weight < w->distR) {
+					w->distR = v->distR + e.weight;
+					w->pathR = v;
+					qb.push(Entry(w->distR, w));
+				}
+				if (w->dist != INF && w->dist + w->distR < best) {
+					best = w->dist + w->distR;
+					meet = w;
+				}
+			}
+		}
+	}
+	if (meet == nullptr)
+		return vector<T>();
+
+	// continue the forward labels along the backward part of the path
+	for (auto v = meet; v != t; v = v->pathR) {
+		v->pathR->dist = v->dist + v->distR - v->pathR->distR;
+		v->pathR->path = v;
+	}
+	return getPath(origin, dest);
+}
+
+/**
+ * A* search from origin to dest. The heuristic receives a vertex content and the
+ * destination and must not overestimate the distance between them (admissible),
+ * or the path returned may not be the shortest: euclideanHeuristic when edge
+ * weights are at least the Euclidean distance between their endpoints (as in
+ * the maps of TP6), manhattanHeuristic only when they are at least the Manhattan
+ * distance (e.g. grids with axis-aligned edges).
+ * Vertices are ordered in the queue by dist + estimate (see Vertex::operator<).
+ * Stops when the destination is settled. Returns the path, as getPath.
+ */
+template<class T>
+template<class Q>
+vector<T> Graph<T>::aStarShortestPath(const T &origin, const T &dest, function<double(const T &, const T &)> heuristic) {
+	settled = 0;
+	auto t = findVertex(dest);
+	if (t == nullptr || findVertex(origin) == nullptr)
+		return vector<T>();
+	auto s = initSingleSource(origin);
+	s->estimate = heuristic(s->info, dest);
+	Q q;
+	q.insert(s);
+	while( ! q.empty() ) {
+		auto v = q.extractMin();
+		settled++;
+		if (v == t)
+			break;
+		for(auto &e : v->adj) {
+			if (relax(v, e.dest, e.weight)) {
+				if (e.dest->queueIndex == 0) { // new, or reopened by an inconsistent heuristic
+					e.dest->estimate = heuristic(e.dest->info, dest);
+					q.insert(e.dest);
+				}
+				else
+					q.decreaseKey(e.dest);
+			}
+		}
+	}
+	return getPath(origin, dest);
+}
+
+/**
+ * Number of vertices settled (removed from a queue) by the last point-to-point query.
+ */
+template<class T>
+int Graph<T>::getNumSettled() const {
+	return settled;
+}
+
 template<class T>
 void Graph<T>::unweightedShortestPath(const T &orig) {
 	auto s = initSingleSource(orig);
@@ -281,83 +534,285 @@ void Graph<T>::unweightedShortestPath(const T &orig) {
 	}
 }
 
+/*
+ * Runs on a frozen copy of the graph, with numThreads threads (see
+ * setNumThreads and FrozenGraph::bellmanFordShortestPath); with queue, uses
+ * the queue-based variant (SPFA).
+ * Returns false if there is a negative cycle reachable from the source, which
+ * can then be obtained with getNegativeCycle, or if orig is not in the graph.
+ */
 template<class T>
-void Graph<T>::bellmanFordShortestPath(const T &orig) {
-	initSingleSource(orig);
-	for (unsigned i = 1; i < vertexSet.size(); i++)
-		for (auto v: vertexSet)
-			for (auto e: v->adj)
-				relax(v, e.dest, e.weight);
-	for (auto v: vertexSet)
-		for (auto e: v->adj)
-			if (relax(v, e.dest, e.weight))
-				cout << "Negative cycle!" << endl;
+bool Graph<T>::bellmanFordShortestPath(const T &orig, bool queue) {
+	FrozenGraph<T> g = freeze();
+	SearchContext ctx;
+	bool res = g.bellmanFordShortestPath(orig, ctx, queue, numThreads);
+	copySearch(ctx);
+	negativeCycle = g.getNegativeCycle(ctx);
+	return res;
 }
 
+template<class T>
+vector<T> Graph<T>::getNegativeCycle() const {
+	return negativeCycle;
+}
 
-/**************** All Pairs Shortest Path  ***************/
 
-template <class T>
-void deleteMatrix(T **m, int n) {
-	if (m != nullptr) {
-		for (int i = 0; i < n; i++)
-			if (m[i] != nullptr)
-				delete [] m[i];
-		delete [] m;
+/*
+ * Parallel delta-stepping, with numThreads threads (see setNumThreads),
+ * on a frozen copy of the graph (see FrozenGraph::deltaSteppingShortestPath).
+ * Gives the same distances as dijkstraShortestPath.
+ */
+template<class T>
+void Graph<T>::deltaSteppingShortestPath(const T &orig, double delta) {
+	FrozenGraph<T> g = freeze();
+	SearchContext ctx;
+	g.deltaSteppingShortestPath(orig, delta, numThreads, ctx);
+	copySearch(ctx);
+}
+
+/*
+ * Copies the labels (dist, path) of a search on the frozen graph to the
+ * vertices (vertex ids are positions in vertexSet, see freeze).
+ */
+template<class T>
+void Graph<T>::copySearch(const SearchContext &ctx) {
+	for (unsigned i = 0; i < vertexSet.size(); i++) {
+		vertexSet[i]->dist = ctx.getDist(i);
+		int p = ctx.getPath(i);
+		vertexSet[i]->path = p == -1 ? nullptr : vertexSet[p];
 	}
 }
 
+/**
+ * Heuristics for aStarShortestPath, for vertex contents with coordinates:
+ * pair<X,Y> (as in grids) or any type with fields x and y (as in map nodes).
+ */
+template <class A, class B>
+double coordX(const pair<A, B> &p) { return p.first; }
+template <class A, class B>
+double coordY(const pair<A, B> &p) { return p.second; }
+template <class P>
+double coordX(const P &p) { return p.x; }
+template <class P>
+double coordY(const P &p) { return p.y; }
 
+template <class T>
+double euclideanHeuristic(const T &v, const T &dest) {
+	double dx = coordX(v) - coordX(dest), dy = coordY(v) - coordY(dest);
+	return sqrt(dx * dx + dy * dy);
+}
 
+/*
+ * Not admissible when edges may be diagonal (it overestimates their length by
+ * up to sqrt(2)): use only with axis-aligned edges, see aStarShortestPath.
+ */
 template <class T>
-Graph<T>::~Graph() {
-	deleteMatrix(W, vertexSet.size());
-	deleteMatrix(P, vertexSet.size());
+double manhattanHeuristic(const T &v, const T &dest) {
+	return fabs(coordX(v) - coordX(dest)) + fabs(coordY(v) - coordY(dest));
 }
 
+
+/**************** All Pairs Shortest Path  ***************/
+
+#define FW_BLOCK 64
+
+/*
+ * Runs the Floyd-Warshall updates for k in [k0, k1) on the cells (i, j) with
+ * i in [i0, i1) and j in [j0, j1) of the n x n matrices W (dist) and P (path).
+ * The inner loop has no branches, so that it can be vectorized.
+ */
+inline void floydWarshallBlock(double *W, int *P, unsigned n, unsigned k0, unsigned k1,
+		unsigned i0, unsigned i1, unsigned j0, unsigned j1) {
+	for (unsigned k = k0; k < k1; k++) {
+		const double *Wk = W + (size_t) k * n;
+		const int *Pk = P + (size_t) k * n;
+		for (unsigned i = i0; i < i1; i++) {
+			double *Wi = W + (size_t) i * n;
+			int *Pi = P + (size_t) i * n;
+			double wik = Wi[k];
+			if (wik == numeric_limits<double>::infinity())
+				continue;
+			for (unsigned j = j0; j < j1; j++) {
+				double val = wik + Wk[j];
+				bool better = val < Wi[j];
+				Wi[j] = better ? val : Wi[j];
+				Pi[j] = better ? Pk[j] : Pi[j];
+			}
+		}
+	}
+}
+
+/*
+ * Runs task(0), ..., task(count-1) using up to numThreads threads.
+ */
+template <class Task>
+void runParallel(unsigned count, unsigned numThreads, Task task) {
+	if (numThreads <= 1 || count <= 1) {
+		for (unsigned t = 0; t < count; t++)
+			task(t);
+		return;
+	}
+	atomic<unsigned> next(0);
+	vector<thread> threads;
+	for (unsigned i = 0; i < min(numThreads, count); i++)
+		threads.push_back(thread([&next, count, &task] {
+			for (unsigned t = next++; t < count; t = next++)
+				task(t);
+		}));
+	for (auto &t : threads)
+		t.join();
+}
+
+/*
+ * Defines the number of threads used by the parallel algorithms.
+ */
+template<class T>
+void Graph<T>::setNumThreads(int num) {
+	numThreads = num;
+}
+
+/*
+ * Blocked (tiled) Floyd-Warshall, on contiguous matrices.
+ * For each diagonal tile (kb, kb): first the diagonal tile is updated,
+ * then the other tiles of row kb and column kb (which only depend on the
+ * diagonal one), then all the remaining tiles (which only depend on the
+ * tiles of row and column kb). The tiles of each of the last two phases
+ * are independent and are distributed across numThreads threads.
+ */
 template<class T>
 void Graph<T>::floydWarshallShortestPath() {
 	unsigned n = vertexSet.size();
-	deleteMatrix(W, n);
-	deleteMatrix(P, n);
-	W = new double *[n];
-	P = new int *[n];
+	const double inf = numeric_limits<double>::infinity();
+	W.assign((size_t) n * n, inf);
+	P.assign((size_t) n * n, -1);
+	unordered_map<Vertex<T> *, int> ids(n);
+	for (unsigned i = 0; i < n; i++)
+		ids[vertexSet[i]] = i;
 	for (unsigned i = 0; i < n; i++) {
-		W[i] = new double[n];
-		P[i] = new int[n];
-		for (unsigned j = 0; j < n; j++) {
-			W[i][j] = i == j? 0 : INF;
-			P[i][j] = -1;
-		}
-		for (auto e : vertexSet[i]->adj) {
-			int j = findVertexIdx(e.dest->info);
-			W[i][j]  = e.weight;
-			P[i][j]  = i;
+		W[(size_t) i * n + i] = 0;
+		for (auto &e : vertexSet[i]->adj) {
+			size_t ij = (size_t) i * n + ids[e.dest];
+			if (e.weight < W[ij]) {
+				W[ij] = e.weight;
+				P[ij] = i;
+			}
 		}
 	}
 
-	for(unsigned k = 0; k < n; k++)
-		for(unsigned i = 0; i < n; i++)
-			for(unsigned j = 0; j < n; j++) {
-				if(W[i][k] == INF || W[k][j] == INF)
-					continue; // avoid overflow
-				int val = W[i][k] + W[k][j];
-				if (val < W[i][j]) {
-					W[i][j] = val;
-					P[i][j] = P[k][j];
+	double *w = W.data();
+	int *p = P.data();
+	unsigned blocks = (n + FW_BLOCK - 1) / FW_BLOCK;
+	auto lo = [](unsigned b) { return b * FW_BLOCK; };
+	auto hi = [n](unsigned b) { return min(n, (b + 1) * FW_BLOCK); };
+	for (unsigned kb = 0; kb < blocks; kb++) {
+		unsigned k0 = lo(kb), k1 = hi(kb);
+		floydWarshallBlock(w, p, n, k0, k1, k0, k1, k0, k1);
+		runParallel(2 * blocks, numThreads, [&](unsigned t) {
+			unsigned b = t / 2;
+			if (b == kb)
+				return;
+			if (t % 2 == 0)
+				floydWarshallBlock(w, p, n, k0, k1, k0, k1, lo(b), hi(b)); // row kb
+			else
+				floydWarshallBlock(w, p, n, k0, k1, lo(b), hi(b), k0, k1); // column kb
+		});
+		runParallel(blocks * blocks, numThreads, [&](unsigned t) {
+			unsigned ib = t / blocks, jb = t % blocks;
+			if (ib != kb && jb != kb)
+				floydWarshallBlock(w, p, n, k0, k1, lo(ib), hi(ib), lo(jb), hi(jb));
+		});
+	}
+
+	for (auto &d : W)
+		if (d == inf)
+			d = INF;
+	fwSize = n;
+}
+
+
+/*
+ * Johnson's algorithm for all pairs shortest paths, for sparse graphs.
+ * Bellman-Ford from a virtual source (connected to every vertex by a zero
+ * weight edge), run by the frozen graph from all the vertices at distance 0,
+ * gives potentials h such that w(u,v) + h(u) - h(v) >= 0.
+ * Then one Dijkstra per source runs on the reweighted CSR graph (see freeze),
+ * with the sources distributed across numThreads threads. Each source writes
+ * its distances and predecessors directly into its own row of W and P,
+ * so the results are queried with getfloydWarshallPath, as for Floyd-Warshall.
+ * Returns false (and no results) if there is a negative cycle.
+ */
+template<class T>
+bool Graph<T>::johnsonAllPairs() {
+	typedef pair<double, int> Entry;
+	FrozenGraph<T> g = freeze();
+	int n = vertexSet.size();
+	W.clear();
+	P.clear();
+	fwSize = 0;
+
+	// Bellman-Ford from the virtual source
+	SearchContext ctx;
+	ctx.reset(n);
+	vector<int> all(n);
+	for (int v = 0; v < n; v++) {
+		all[v] = v;
+		ctx.set(v, 0, -1);
+	}
+	if (!g.bellmanFordFrom(all, ctx, false, numThreads))
+		return false; // negative cycle
+	vector<double> h(n);
+	for (int v = 0; v < n; v++)
+		h[v] = ctx.getDist(v);
+
+	// the reweighted edges are non-negative, up to rounding errors: only
+	// negatives that small are taken as 0
+	for (int v = 0; v < n; v++)
+		for (int e = g.offsets[v]; e < g.offsets[v + 1]; e++) {
+			double w = g.weights[e] + h[v] - h[g.targets[e]];
+			if (w < 0 && w >= -1e-9 * (fabs(g.weights[e]) + fabs(h[v]) + fabs(h[g.targets[e]])))
+				w = 0;
+			g.weights[e] = w;
+		}
+
+	W.assign((size_t) n * n, INF);
+	P.assign((size_t) n * n, -1);
+	runParallel(n, numThreads, [&](unsigned s) {
+		double *dist = W.data() + (size_t) s * n;
+		int *path = P.data() + (size_t) s * n;
+		priority_queue<Entry, vector<Entry>, greater<Entry>> q;
+		dist[s] = 0;
+		q.push(Entry(0, s));
+		while ( ! q.empty() ) {
+			double d = q.top().first;
+			int v = q.top().second;
+			q.pop();
+			if (d > dist[v])
+				continue; // stale entry
+			for (int e = g.offsets[v]; e < g.offsets[v + 1]; e++) {
+				int w = g.targets[e];
+				if (d + g.weights[e] < dist[w]) {
+					dist[w] = d + g.weights[e];
+					path[w] = v;
+					q.push(Entry(dist[w], w));
 				}
 			}
+		}
+		for (int v = 0; v < n; v++)
+			if (dist[v] != INF)
+				dist[v] += h[v] - h[s];
+	});
+	fwSize = n;
+	return true;
 }
 
-
 template<class T>
 vector<T> Graph<T>::getfloydWarshallPath(const T &orig, const T &dest) const{
 	vector<T> res;
 	int i = findVertexIdx(orig);
 	int j = findVertexIdx(dest);
-	if (i == -1 || j == -1 || W[i][j] == INF) // missing or disconnected
+	if (i == -1 || j == -1 || (unsigned) max(i, j) >= fwSize || W[(size_t) i * fwSize + j] == INF) // missing or disconnected
 		return res;
-	for ( ; j != -1; j = P[i][j])
+	for ( ; j != -1; j = P[(size_t) i * fwSize + j])
 		res.push_back(vertexSet[j]->info);
 	reverse(res.begin(), res.end());
 	return res;
@@ -373,10 +828,14 @@ bool Graph<T>::addBidirectionalEdge(const T &sourc, const T &dest, double w) {
 
 
 
+/*
+ * The priority queue implementation (Q) can be chosen as in dijkstraShortestPath.
+ */
 template <class T>
+template <class Q>
 vector<Vertex<T>* > Graph<T>::calculatePrim() {
     auto s = initSingleSource(vertexSet.at(0)->getInfo());
-    MutablePriorityQueue<Vertex<T>> q;
+    Q q;
     q.insert(s);
     while( ! q.empty() ) {
         auto v = q.extractMin();
@@ -0,0 +1,218 @@
+/*
+ * GraphBuilder.h
+ * Bulk construction of a Graph from whole vertex and edge arrays, or from the
+ * map files of TP6 (nos.txt and arestas.txt), without calling addEdge per edge.
+ */
+
+#ifndef GRAPHBUILDER_H_
+#define GRAPHBUILDER_H_
+
+#include <vector>
+#include <string>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <cmath>
+#include "Graph.h"
+#include "TextParser.h"
+
+using namespace std;
+
+/*
+ * Vertices get dense ids (0..n-1), in the order they are given, and edges
+ * refer to them by id. build then sorts the edges by source with a counting
+ * sort split across numThreads threads, which keeps the edges of each vertex
+ * in the order they were given (as addEdge would), and creates the adjacency
+ * lists, with their exact sizes, in a single pass.
+ */
+template <class T>
+class GraphBuilder {
+	vector<T> vertices;
+	vector<int> sources, dests;  // edges, by insertion order
+	vector<double> weights;
+	int numThreads = 1;
+
+public:
+	GraphBuilder() = default;
+	GraphBuilder(const vector<T> &vertices, const vector<int> &sources, const vector<int> &dests, const vector<double> &weights);
+	int addVertex(const T &in);
+	bool addEdge(int source, int dest, double w);
+	bool addBidirectionalEdge(int source, int dest, double w);
+	bool readMap(const string &dir, function<T(int id, double x, double y)> makeVertex);
+	void setNumThreads(int num);
+	int getNumVertex() const;
+	int getNumEdges() const;
+	bool isValid() const;
+	bool build(Graph<T> &g) const;
+};
+
+/*
+ * Takes the vertices and the edges (source id, destination id and weight of
+ * edge i in sources[i], dests[i] and weights[i]) at once. They are not checked
+ * here, but by build (see isValid).
+ */
+template <class T>
+GraphBuilder<T>::GraphBuilder(const vector<T> &vertices, const vector<int> &sources, const vector<int> &dests, const vector<double> &weights):
+	vertices(vertices), sources(sources), dests(dests), weights(weights) {}
+
+/*
+ * Adds a vertex and returns its id. Contents are checked for duplicates by
+ * build, if the graph has a hasher.
+ */
+template <class T>
+int GraphBuilder<T>::addVertex(const T &in) {
+	vertices.push_back(in);
+	return vertices.size() - 1;
+}
+
+/*
+ * Adds an edge between the vertices with the given ids.
+ * Returns false, adding nothing, if one of them does not exist.
+ */
+template <class T>
+bool GraphBuilder<T>::addEdge(int source, int dest, double w) {
+	int n = vertices.size();
+	if (source < 0 || source >= n || dest < 0 || dest >= n)
+		return false;
+	sources.push_back(source);
+	dests.push_back(dest);
+	weights.push_back(w);
+	return true;
+}
+
+template <class T>
+bool GraphBuilder<T>::addBidirectionalEdge(int source, int dest, double w) {
+	return addEdge(source, dest, w) && addEdge(dest, source, w);
+}
+
+/*
+ * Reads a map in the format of TP6: dir/nos.txt with lines "id;x;y" and
+ * dir/arestas.txt with lines "id;node1;node2". Each node becomes a vertex,
+ * created with makeVertex, and each edge a pair of opposite edges weighted
+ * by the Euclidean distance between its nodes.
+ * Returns false if a file cannot be read, a node id is repeated or an edge
+ * refers to a missing node.
+ */
+template <class T>
+bool GraphBuilder<T>::readMap(const string &dir, function<T(int id, double x, double y)> makeVertex) {
+	TextParser nodeFile(dir + "/nos.txt"), edgeFile(dir + "/arestas.txt");
+	if (!nodeFile.isOpen() || !edgeFile.isOpen())
+		return false;
+	unordered_map<int, int> ids;   // node id in the file -> vertex id
+	vector<double> xs, ys;
+	int id, n1, n2;
+	double x, y;
+	while (nodeFile.next(id) && nodeFile.next(x) && nodeFile.next(y)) {
+		if (ids.count(id))
+			return false;
+		ids[id] = addVertex(makeVertex(id, x, y));
+		xs.push_back(x);
+		ys.push_back(y);
+	}
+	while (edgeFile.next(id) && edgeFile.next(n1) && edgeFile.next(n2)) {
+		auto i1 = ids.find(n1), i2 = ids.find(n2);
+		if (i1 == ids.end() || i2 == ids.end())
+			return false;
+		int v = i1->second, w = i2->second;
+		addBidirectionalEdge(v, w, hypot(xs[v] - xs[w], ys[v] - ys[w]));
+	}
+	return true;
+}
+
+template <class T>
+void GraphBuilder<T>::setNumThreads(int num) {
+	numThreads = num;
+}
+
+template <class T>
+int GraphBuilder<T>::getNumVertex() const {
+	return vertices.size();
+}
+
+template <class T>
+int GraphBuilder<T>::getNumEdges() const {
+	return sources.size();
+}
+
+/*
+ * Checks that there is a source, a destination and a weight for every edge,
+ * and that every source and destination is the id of a vertex.
+ */
+template <class T>
+bool GraphBuilder<T>::isValid() const {
+	int n = vertices.size();
+	if (dests.size() != sources.size() || weights.size() != sources.size())
+		return false;
+	for (unsigned e = 0; e < sources.size(); e++)
+		if (sources[e] < 0 || sources[e] >= n || dests[e] < 0 || dests[e] >= n)
+			return false;
+	return true;
+}
+
+/*
+ * Adds the vertices and edges to graph g, after the vertices it already has
+ * (the new edges only connect new vertices). Its hasher, if set with
+ * setHasher before, is used to index the new vertices.
+ * As with Graph::addVertex, the contents of the vertices must be distinct and
+ * not in g already; this is checked only if g has a hasher (without one,
+ * it would take O(n) time per vertex).
+ * Returns false, leaving g unchanged, if the edges are not valid (see isValid)
+ * or if g has a hasher and some contents are repeated.
+ */
+template <class T>
+bool GraphBuilder<T>::build(Graph<T> &g) const {
+	if (!isValid())
+		return false;
+	if (g.indexed) {
+		unordered_set<T, function<size_t(const T &)>> seen(vertices.size(), g.vertexIndex.hash_function());
+		for (auto &in : vertices)
+			if (g.vertexIndex.count(in) || !seen.insert(in).second)
+				return false;
+	}
+	unsigned n = vertices.size(), m = sources.size();
+	unsigned nt = max(1u, min((unsigned) numThreads, m / 4096 + 1));
+
+	// counting sort by source: each thread counts the edges of its chunk ...
+	vector<vector<int>> count(nt, vector<int>(n + 1, 0));
+	runParallel(nt, nt, [&](unsigned t) {
+		for (unsigned e = (size_t) m * t / nt; e < (size_t) m * (t + 1) / nt; e++)
+			count[t][sources[e]]++;
+	});
+	// ... then gets, for each source, where its first edge goes ...
+	vector<int> offsets(n + 1, 0);
+	for (unsigned v = 0; v < n; v++) {
+		int total = offsets[v];
+		for (unsigned t = 0; t < nt; t++) {
+			int c = count[t][v];
+			count[t][v] = total;
+			total += c;
+		}
+		offsets[v + 1] = total;
+	}
+	// ... and places its edges there, in order
+	vector<int> order(m);
+	runParallel(nt, nt, [&](unsigned t) {
+		for (unsigned e = (size_t) m * t / nt; e < (size_t) m * (t + 1) / nt; e++)
+			order[count[t][sources[e]]++] = e;
+	});
+
+	unsigned first = g.vertexSet.size();
+	g.vertexSet.reserve(first + n);
+	for (auto &in : vertices) {
+		g.vertexSet.push_back(new Vertex<T>(in));
+		if (g.indexed)
+			g.vertexIndex.emplace(in, g.vertexSet.back());
+	}
+	Vertex<T> **vs = g.vertexSet.data() + first;
+	runParallel(nt, nt, [&](unsigned t) {
+		for (unsigned v = (size_t) n * t / nt; v < (size_t) n * (t + 1) / nt; v++) {
+			vs[v]->adj.reserve(offsets[v + 1] - offsets[v]);
+			for (int i = offsets[v]; i < offsets[v + 1]; i++)
+				vs[v]->adj.push_back(Edge<T>(vs[v], vs[dests[order[i]]], weights[order[i]]));
+		}
+	});
+	g.reverseValid = false;
+	return true;
+}
+
+#endif /* GRAPHBUILDER_H_ */
@@ -0,0 +1,322 @@
+/*
+ * MappedGraph.h
+ * Read-only graph stored in a binary file, which is mapped into memory
+ * (mmap) and used in place, without parsing or copying.
+ */
+
+#ifndef MAPPEDGRAPH_H_
+#define MAPPEDGRAPH_H_
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <algorithm>
+#include "Graph.h"
+#include "GraphBuilder.h"
+#ifdef _WIN32
+#include <memory>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#define MAPPEDGRAPH_MAGIC 0x474c4143    // "CALG", in little endian
+#define MAPPEDGRAPH_VERSION 1
+
+/*
+ * File format (version 1), in the byte order of the machine that wrote it:
+ * this header, then the arrays at the given positions (each aligned to 8 bytes):
+ *   offsets  int64[numVertex + 1]  first edge of each vertex (CSR, see FrozenGraph)
+ *   targets  int32[numEdges]       destination vertex id, by edge
+ *   weights  double[numEdges]      edge weight, by edge
+ *   coords   double[2 * numVertex] x and y of each vertex (if coordsPos != 0)
+ */
+struct MappedGraphHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t numVertex;
+	uint64_t numEdges;
+	uint64_t offsetsPos, targetsPos, weightsPos, coordsPos;
+};
+
+class MappedGraph {
+	const char *data = nullptr;   // the whole file
+	size_t size = 0;
+#ifdef _WIN32
+	unique_ptr<char[]> buffer;    // no mmap: the file is read into memory
+#endif
+	const MappedGraphHeader *header = nullptr;
+	const int64_t *offsets = nullptr;
+	const int32_t *targets = nullptr;
+	const double *weights = nullptr;
+	const double *coords = nullptr;
+
+	bool validate();
+public:
+	MappedGraph() = default;
+	MappedGraph(const MappedGraph &) = delete;
+	MappedGraph &operator=(const MappedGraph &) = delete;
+	~MappedGraph();
+
+	bool open(const string &file);
+	void close();
+	bool isOpen() const;
+
+	int getNumVertex() const;
+	long getNumEdges() const;
+	long edgesBegin(int v) const;
+	long edgesEnd(int v) const;
+	int getTarget(long e) const;
+	double getWeight(long e) const;
+	bool hasCoords() const;
+	double getX(int v) const;
+	double getY(int v) const;
+
+	void dijkstraShortestPath(int s, SearchContext &ctx) const;
+
+	static bool write(const string &file, const vector<int64_t> &offsets, const vector<int32_t> &targets,
+			const vector<double> &weights, const vector<double> &coords);
+	template <class T>
+	static bool write(const string &file, const FrozenGraph<T> &g, function<pair<double, double>(const T &)> coords = nullptr);
+	static bool convertMap(const string &dir, const string &file);
+};
+
+inline MappedGraph::~MappedGraph() {
+	close();
+}
+
+/*
+ * Maps a file written by write. Returns false if it cannot be read or is not
+ * a valid graph file of this version (see validate, which reads the offsets
+ * and targets once, so opening takes O(n + m) time).
+ */
+inline bool MappedGraph::open(const string &file) {
+	close();
+#ifdef _WIN32
+	ifstream is(file, ios::binary | ios::ate);
+	if (!is)
+		return false;
+	size = is.tellg();
+	buffer.reset(new char[size]);
+	is.seekg(0);
+	if (!is.read(buffer.get(), size)) {
+		close();
+		return false;
+	}
+	data = buffer.get();
+#else
+	int fd = ::open(file.c_str(), O_RDONLY);
+	if (fd == -1)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) == -1 || st.st_size == 0) {
+		::close(fd);
+		return false;
+	}
+	size = st.st_size;
+	void *p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd); // the mapping stays valid
+	if (p == MAP_FAILED) {
+		size = 0;
+		return false;
+	}
+	data = (const char *) p;
+#endif
+	if (!validate()) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+/*
+ * Checks the header, that the arrays fit in the file, that the offsets start
+ * at 0, never decrease and end at numEdges, and that every target is a vertex.
+ */
+inline bool MappedGraph::validate() {
+	if (size < sizeof(MappedGraphHeader))
+		return false;
+	header = (const MappedGraphHeader *) data;
+	if (header->magic != MAPPEDGRAPH_MAGIC || header->version != MAPPEDGRAPH_VERSION)
+		return false;
+	uint64_t n = header->numVertex, m = header->numEdges;
+	auto fits = [this](uint64_t pos, uint64_t bytes) { return pos % 8 == 0 && pos <= size && bytes <= size - pos; };
+	if (n >= INT32_MAX || m >= (uint64_t) INT64_MAX / 8
+			|| !fits(header->offsetsPos, (n + 1) * 8) || !fits(header->targetsPos, m * 4)
+			|| !fits(header->weightsPos, m * 8) || (header->coordsPos != 0 && !fits(header->coordsPos, n * 16)))
+		return false;
+	offsets = (const int64_t *) (data + header->offsetsPos);
+	targets = (const int32_t *) (data + header->targetsPos);
+	weights = (const double *) (data + header->weightsPos);
+	coords = header->coordsPos != 0 ? (const double *) (data + header->coordsPos) : nullptr;
+	if (offsets[0] != 0 || offsets[n] != (int64_t) m)
+		return false;
+	for (uint64_t v = 0; v < n; v++)
+		if (offsets[v + 1] < offsets[v] || offsets[v + 1] > (int64_t) m)
+			return false;
+	for (uint64_t e = 0; e < m; e++)
+		if (targets[e] < 0 || (uint64_t) targets[e] >= n)
+			return false;
+	return true;
+}
+
+inline void MappedGraph::close() {
+#ifdef _WIN32
+	buffer.reset();
+#else
+	if (data != nullptr)
+		munmap((void *) data, size);
+#endif
+	data = nullptr;
+	size = 0;
+	header = nullptr;
+	offsets = nullptr;
+	targets = nullptr;
+	weights = nullptr;
+	coords = nullptr;
+}
+
+inline bool MappedGraph::isOpen() const {
+	return header != nullptr;
+}
+
+inline int MappedGraph::getNumVertex() const {
+	return header->numVertex;
+}
+
+inline long MappedGraph::getNumEdges() const {
+	return header->numEdges;
+}
+
+/*
+ * The outgoing edges of vertex v are edgesBegin(v), ..., edgesEnd(v) - 1.
+ */
+inline long MappedGraph::edgesBegin(int v) const {
+	return offsets[v];
+}
+
+inline long MappedGraph::edgesEnd(int v) const {
+	return offsets[v + 1];
+}
+
+inline int MappedGraph::getTarget(long e) const {
+	return targets[e];
+}
+
+inline double MappedGraph::getWeight(long e) const {
+	return weights[e];
+}
+
+inline bool MappedGraph::hasCoords() const {
+	return coords != nullptr;
+}
+
+inline double MappedGraph::getX(int v) const {
+	return coords[2 * v];
+}
+
+inline double MappedGraph::getY(int v) const {
+	return coords[2 * v + 1];
+}
+
+/*
+ * Same as FrozenGraph::dijkstraShortestPath, from the vertex with id s.
+ */
+inline void MappedGraph::dijkstraShortestPath(int s, SearchContext &ctx) const {
+	ctx.reset(getNumVertex());
+	ctx.set(s, 0, -1);
+	auto &q = ctx.heap;
+	auto cmp = greater<pair<double, int>>();
+	q.push_back(make_pair(0.0, s));
+	while( ! q.empty() ) {
+		pop_heap(q.begin(), q.end(), cmp);
+		auto top = q.back();
+		q.pop_back();
+		int v = top.second;
+		if (top.first > ctx.getDist(v))
+			continue; // stale entry
+		for (long e = offsets[v]; e < offsets[v + 1]; e++) {
+			double d = top.first + weights[e];
+			if (d < ctx.getDist(targets[e])) {
+				ctx.set(targets[e], d, v);
+				q.push_back(make_pair(d, targets[e]));
+				push_heap(q.begin(), q.end(), cmp);
+			}
+		}
+	}
+}
+
+/*
+ * Writes a graph given in CSR form, with coordinates (x and y of each vertex,
+ * interleaved) or without them (empty coords).
+ */
+inline bool MappedGraph::write(const string &file, const vector<int64_t> &offsets, const vector<int32_t> &targets,
+		const vector<double> &weights, const vector<double> &coords) {
+	MappedGraphHeader h;
+	memset(&h, 0, sizeof(h));
+	h.magic = MAPPEDGRAPH_MAGIC;
+	h.version = MAPPEDGRAPH_VERSION;
+	h.numVertex = offsets.size() - 1;
+	h.numEdges = targets.size();
+	auto align = [](uint64_t pos) { return (pos + 7) / 8 * 8; };
+	h.offsetsPos = align(sizeof(h));
+	h.targetsPos = align(h.offsetsPos + offsets.size() * sizeof(int64_t));
+	h.weightsPos = align(h.targetsPos + targets.size() * sizeof(int32_t));
+	h.coordsPos = coords.empty() ? 0 : align(h.weightsPos + weights.size() * sizeof(double));
+
+	ofstream os(file, ios::binary);
+	uint64_t pos = 0;
+	auto put = [&os, &pos](uint64_t at, const void *p, size_t bytes) {
+		static const char zeros[8] = {0};
+		os.write(zeros, at - pos);
+		os.write((const char *) p, bytes);
+		pos = at + bytes;
+	};
+	put(0, &h, sizeof(h));
+	put(h.offsetsPos, offsets.data(), offsets.size() * sizeof(int64_t));
+	put(h.targetsPos, targets.data(), targets.size() * sizeof(int32_t));
+	put(h.weightsPos, weights.data(), weights.size() * sizeof(double));
+	if (!coords.empty())
+		put(h.coordsPos, coords.data(), coords.size() * sizeof(double));
+	return (bool) os;
+}
+
+/*
+ * Writes a frozen graph, with the coordinates of each vertex given by coords
+ * (if not null).
+ */
+template <class T>
+bool MappedGraph::write(const string &file, const FrozenGraph<T> &g, function<pair<double, double>(const T &)> coords) {
+	vector<double> xy;
+	if (coords)
+		for (auto &in : g.info) {
+			auto c = coords(in);
+			xy.push_back(c.first);
+			xy.push_back(c.second);
+		}
+	return write(file, vector<int64_t>(g.offsets.begin(), g.offsets.end()), vector<int32_t>(g.targets.begin(), g.targets.end()), g.weights, xy);
+}
+
+/*
+ * Converts a map in the text format of TP6 (see GraphBuilder::readMap) to a
+ * graph file. Vertex ids follow the order of the nodes in nos.txt.
+ */
+inline bool MappedGraph::convertMap(const string &dir, const string &file) {
+	GraphBuilder<int> builder;
+	vector<pair<double, double>> xy;
+	if (!builder.readMap(dir, [&xy](int, double x, double y) { xy.push_back(make_pair(x, y)); return (int) xy.size() - 1; }))
+		return false;
+	Graph<int> g;
+	if (!builder.build(g))
+		return false;
+	return write<int>(file, g.freeze(), [&xy](const int &v) { return xy[v]; });
+}
+
+#endif /* MAPPEDGRAPH_H_ */
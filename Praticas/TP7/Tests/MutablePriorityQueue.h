@@ -16,14 +16,32 @@ using namespace std;
 
 /**
  * class T must have: (i) accessible field int queueIndex; (ii) operator< defined.
+ *
+ * The implementation is chosen at compile time by the Policy parameter:
+ * DaryHeap<D> (implicit D-ary heap, binary by default) or PairingHeap.
+ * Both have the same interface.
  */
 
-template <class T>
-class MutablePriorityQueue {
+template <unsigned D>
+struct DaryHeap {};
+
+struct PairingHeap {};
+
+template <class T, class Policy = DaryHeap<2>>
+class MutablePriorityQueue;
+
+/*************************** D-ary heap **************************/
+
+template <class T, unsigned D>
+class MutablePriorityQueue<T, DaryHeap<D>> {
 	vector<T *> H;
 	void heapifyUp(unsigned i);
 	void heapifyDown(unsigned i);
 	inline void set(unsigned i, T * x);
+
+	// Index calculations
+	static unsigned parent(unsigned i) { return (i - 2) / D + 1; }
+	static unsigned firstChild(unsigned i) { return D * (i - 1) + 2; }
 public:
 	MutablePriorityQueue();
 	void insert(T * x);
@@ -32,45 +50,42 @@ public:
 	bool empty();
 };
 
-// Index calculations
-#define parent(i) ((i) / 2)
-#define leftChild(i) ((i) * 2)
-
-template <class T>
-MutablePriorityQueue<T>::MutablePriorityQueue() {
+template <class T, unsigned D>
+MutablePriorityQueue<T, DaryHeap<D>>::MutablePriorityQueue() {
 	H.push_back(nullptr);
 	// indices will be used starting in 1
 	// to facilitate parent/child calculations
 }
 
-template <class T>
-bool MutablePriorityQueue<T>::empty() {
+template <class T, unsigned D>
+bool MutablePriorityQueue<T, DaryHeap<D>>::empty() {
 	return H.size() == 1;
 }
 
-template <class T>
-T* MutablePriorityQueue<T>::extractMin() {
+template <class T, unsigned D>
+T* MutablePriorityQueue<T, DaryHeap<D>>::extractMin() {
 	auto x = H[1];
 	H[1] = H.back();
 	H.pop_back();
-	heapifyDown(1);
+	if (H.size() > 1)
+		heapifyDown(1);
 	x->queueIndex = 0;
 	return x;
 }
 
-template <class T>
-void MutablePriorityQueue<T>::insert(T *x) {
+template <class T, unsigned D>
+void MutablePriorityQueue<T, DaryHeap<D>>::insert(T *x) {
 	H.push_back(x);
 	heapifyUp(H.size()-1);
 }
 
-template <class T>
-void MutablePriorityQueue<T>::decreaseKey(T *x) {
+template <class T, unsigned D>
+void MutablePriorityQueue<T, DaryHeap<D>>::decreaseKey(T *x) {
 	heapifyUp(x->queueIndex);
 }
 
-template <class T>
-void MutablePriorityQueue<T>::heapifyUp(unsigned i) {
+template <class T, unsigned D>
+void MutablePriorityQueue<T, DaryHeap<D>>::heapifyUp(unsigned i) {
 	auto x = H[i];
 	while (i > 1 && *x < *H[parent(i)]) {
 		set(i, H[parent(i)]);
@@ -79,15 +94,17 @@ void MutablePriorityQueue<T>::heapifyUp(unsigned i) {
 	set(i, x);
 }
 
-template <class T>
-void MutablePriorityQueue<T>::heapifyDown(unsigned i) {
+template <class T, unsigned D>
+void MutablePriorityQueue<T, DaryHeap<D>>::heapifyDown(unsigned i) {
 	auto x = H[i];
 	while (true) {
-		unsigned k = leftChild(i);
+		unsigned k = firstChild(i);
 		if (k >= H.size())
 			break;
-		if (k+1 < H.size() && *H[k+1] < *H[k])
-			++k; // right child of i
+		unsigned last = k + D < H.size() ? k + D : H.size();
+		for (unsigned c = k + 1; c < last; c++)
+			if (*H[c] < *H[k])
+				k = c; // smallest child of i
 		if ( ! (*H[k] < *x) )
 			break;
 		set(i, H[k]);
@@ -96,10 +113,124 @@ void MutablePriorityQueue<T>::heapifyDown(unsigned i) {
 	set(i, x);
 }
 
-template <class T>
-void MutablePriorityQueue<T>::set(unsigned i, T * x) {
+template <class T, unsigned D>
+void MutablePriorityQueue<T, DaryHeap<D>>::set(unsigned i, T * x) {
 	H[i] = x;
 	x->queueIndex = i;
 }
 
+/*************************** Pairing heap **************************/
+
+/*
+ * Nodes are kept in a vector and referenced by index (0 means none),
+ * so queueIndex holds the index of the element's node.
+ * Each node points to its first child and next sibling, and to its
+ * previous sibling (or parent, for a first child) so it can be cut in decreaseKey.
+ */
+template <class T>
+class MutablePriorityQueue<T, PairingHeap> {
+	struct Node {
+		T * x;
+		unsigned child, next, prev;
+	};
+	vector<Node> nodes;
+	vector<unsigned> freeNodes;
+	vector<unsigned> pairs;     // auxiliary buffer used by extractMin
+	unsigned root = 0;
+	unsigned meld(unsigned a, unsigned b);
+public:
+	MutablePriorityQueue();
+	void insert(T * x);
+	T * extractMin();
+	void decreaseKey(T * x);
+	bool empty();
+};
+
+template <class T>
+MutablePriorityQueue<T, PairingHeap>::MutablePriorityQueue() {
+	nodes.push_back(Node{nullptr, 0, 0, 0});
+}
+
+template <class T>
+bool MutablePriorityQueue<T, PairingHeap>::empty() {
+	return root == 0;
+}
+
+/*
+ * Links two trees (given by their roots), making the one with the
+ * larger key the first child of the other. Returns the new root.
+ */
+template <class T>
+unsigned MutablePriorityQueue<T, PairingHeap>::meld(unsigned a, unsigned b) {
+	if (a == 0)
+		return b;
+	if (b == 0)
+		return a;
+	if (*nodes[b].x < *nodes[a].x)
+		swap(a, b);
+	nodes[b].prev = a;
+	nodes[b].next = nodes[a].child;
+	if (nodes[a].child != 0)
+		nodes[nodes[a].child].prev = b;
+	nodes[a].child = b;
+	return a;
+}
+
+template <class T>
+void MutablePriorityQueue<T, PairingHeap>::insert(T *x) {
+	unsigned i;
+	if (freeNodes.empty()) {
+		i = nodes.size();
+		nodes.push_back(Node{x, 0, 0, 0});
+	}
+	else {
+		i = freeNodes.back();
+		freeNodes.pop_back();
+		nodes[i] = Node{x, 0, 0, 0};
+	}
+	x->queueIndex = i;
+	root = meld(root, i);
+}
+
+/*
+ * Removes the root and melds its children with the standard two-pass
+ * strategy: pairwise from left to right, then from right to left.
+ */
+template <class T>
+T* MutablePriorityQueue<T, PairingHeap>::extractMin() {
+	unsigned r = root;
+	auto x = nodes[r].x;
+	pairs.clear();
+	for (unsigned c = nodes[r].child; c != 0; ) {
+		unsigned a = c, b = nodes[a].next;
+		c = b != 0 ? nodes[b].next : 0;
+		nodes[a].next = nodes[a].prev = 0;
+		if (b != 0)
+			nodes[b].next = nodes[b].prev = 0;
+		pairs.push_back(meld(a, b));
+	}
+	root = 0;
+	for (unsigned i = pairs.size(); i > 0; i--)
+		root = meld(pairs[i - 1], root);
+	freeNodes.push_back(r);
+	x->queueIndex = 0;
+	return x;
+}
+
+template <class T>
+void MutablePriorityQueue<T, PairingHeap>::decreaseKey(T *x) {
+	unsigned i = x->queueIndex;
+	if (i == root)
+		return;
+	unsigned p = nodes[i].prev;
+	if (nodes[p].child == i)
+		nodes[p].child = nodes[i].next;
+	else
+		nodes[p].next = nodes[i].next;
+	if (nodes[i].next != 0)
+		nodes[nodes[i].next].prev = p;
+	nodes[i].next = nodes[i].prev = 0;
+	root = meld(root, i);
+}
+
 #endif /* SRC_MUTABLEPRIORITYQUEUE_H_ */
@@ -5,7 +5,13 @@
 #include <random>
 #include <time.h>
 #include <chrono>
+#include <fstream>
+#include <thread>
+#include <filesystem>
 #include "Graph.h"
+#include "ContractionHierarchy.h"
+#include "GraphBuilder.h"
+#include "MappedGraph.h"
 
 using namespace std;
 using testing::Eq;
@@ -35,6 +41,904 @@ Graph<int> createTestGraph() {
 
 
 
+TEST(CAL_FP07, testFreeze) {
+	Graph<int> graph = createTestGraph();
+	FrozenGraph<int> frozen = graph.freeze();
+	EXPECT_EQ(7, frozen.getNumVertex());
+	EXPECT_EQ(24, frozen.getNumEdges());
+
+	// source not in the graph: nothing reached
+	frozen.dijkstraShortestPath(99);
+	EXPECT_TRUE(frozen.getPath(99, 1).empty());
+	frozen.unweightedShortestPath(99);
+	EXPECT_TRUE(frozen.getPath(99, 1).empty());
+	EXPECT_FALSE(frozen.bellmanFordShortestPath(99, true));
+	EXPECT_FALSE(frozen.bellmanFordShortestPath(99, false, 2));
+	EXPECT_TRUE(frozen.getNegativeCycle().empty());
+	frozen.deltaSteppingShortestPath(99, 1, 2);
+	EXPECT_TRUE(frozen.getPath(99, 1).empty());
+
+	// path of a search from another source
+	frozen.dijkstraShortestPath(1);
+	EXPECT_FALSE(frozen.getPath(1, 5).empty());
+	EXPECT_TRUE(frozen.getPath(2, 5).empty());
+	EXPECT_TRUE(frozen.getPath(99, 5).empty());
+	graph.dijkstraShortestPath(1);
+	EXPECT_FALSE(graph.getPath(1, 5).empty());
+	EXPECT_TRUE(graph.getPath(2, 5).empty());
+
+	for (int s = 1; s < 8; s++) {
+		graph.dijkstraShortestPath(s);
+		frozen.dijkstraShortestPath(s);
+		for (int d = 1; d < 8; d++)
+			EXPECT_EQ(graph.getPath(s, d), frozen.getPath(s, d));
+
+		graph.unweightedShortestPath(s);
+		frozen.unweightedShortestPath(s);
+		for (int d = 1; d < 8; d++)
+			EXPECT_EQ(graph.getPath(s, d), frozen.getPath(s, d));
+
+		graph.bellmanFordShortestPath(s);
+		frozen.bellmanFordShortestPath(s);
+		for (int d = 1; d < 8; d++)
+			EXPECT_EQ(graph.getPath(s, d), frozen.getPath(s, d));
+	}
+}
+
+/**
+ * n x n grid with edges to the 4 neighbours, with random integer weights in
+ * [1, n] (from a random seed, unless one is given).
+ */
+void generateRandomGridGraph(int n, Graph<pair<int,int>> & g, unsigned seed = std::random_device()()) {
+	std::mt19937 gen(seed);
+	std::uniform_int_distribution<int> dis(1, n);
+
+	g.setHasher([n](const pair<int,int> &p) { return (size_t) (p.first * n + p.second); });
+	for (int i = 0; i < n; i++)
+		for (int j = 0; j < n; j++)
+			g.addVertex(make_pair(i,j));
+
+	for (int i = 0; i < n; i++)
+		for (int j = 0; j < n; j++)
+			for (int di = -1; di <= 1; di++)
+				for (int dj = -1; dj <= 1; dj++)
+					if ((di != 0) != (dj != 0) && i+di >= 0 && i+di < n && j+dj >= 0 && j+dj < n)
+						g.addEdge(make_pair(i,j), make_pair(i+di,j+dj), dis(gen));
+}
+
+TEST(CAL_FP07, testConcurrentQueries) {
+	const int n = 60, numThreads = 4;
+	Graph<pair<int,int>> graph;
+	generateRandomGridGraph(n, graph);
+	const FrozenGraph<pair<int,int>> frozen = graph.freeze();
+
+	// each thread answers its share of the sources with its own context
+	vector<vector<double>> dists(n);
+	vector<thread> threads;
+	for (int t = 0; t < numThreads; t++)
+		threads.push_back(thread([&, t]() {
+			SearchContext ctx;
+			for (int i = t; i < n; i += numThreads) {
+				frozen.dijkstraShortestPath(make_pair(i, (i * 7) % n), ctx);
+				for (int v = 0; v < frozen.getNumVertex(); v++)
+					dists[i].push_back(ctx.getDist(v));
+			}
+		}));
+	for (auto &t : threads)
+		t.join();
+
+	SearchContext ctx;
+	for (int i = 0; i < n; i++) {
+		graph.dijkstraShortestPath(make_pair(i, (i * 7) % n));
+		for (auto v : graph.getVertexSet())
+			EXPECT_EQ(v->getDist(), dists[i][frozen.findVertexId(v->getInfo())]);
+		frozen.unweightedShortestPath(make_pair(i, (i * 7) % n), ctx);
+		// on the grid, the number of edges between two vertices is their Manhattan distance
+		EXPECT_EQ(i + (i * 7) % n, ctx.getDist(frozen.findVertexId(make_pair(0, 0))));
+	}
+}
+
+struct QueueItem {
+	int key;
+	int queueIndex = 0;
+	bool operator<(QueueItem & i) const { return key < i.key; }
+};
+
+template <class Q>
+void checkQueueOrder() {
+	vector<QueueItem> items(200);
+	Q q;
+	for (int i = 0; i < 200; i++) {
+		items[i].key = (i * 73) % 200 + 200;
+		q.insert(&items[i]);
+	}
+	for (int i = 0; i < 200; i += 3) {
+		items[i].key -= 200;
+		q.decreaseKey(&items[i]);
+	}
+	int last = -1;
+	for (int i = 0; i < 100; i++) {
+		QueueItem * x = q.extractMin();
+		EXPECT_LE(last, x->key);
+		EXPECT_EQ(0, x->queueIndex);
+		last = x->key;
+	}
+	for (int i = 0; i < 100; i++) {
+		items[i].key = -1 - i; // reinsert extracted items with smaller keys
+		if (items[i].queueIndex == 0)
+			q.insert(&items[i]);
+		else
+			q.decreaseKey(&items[i]);
+	}
+	last = -1000;
+	int count = 0;
+	while (!q.empty()) {
+		QueueItem * x = q.extractMin();
+		EXPECT_LE(last, x->key);
+		last = x->key;
+		count++;
+	}
+	EXPECT_LE(100, count);
+}
+
+TEST(CAL_FP07, testQueuePolicies) {
+	checkQueueOrder<MutablePriorityQueue<QueueItem>>();
+	checkQueueOrder<MutablePriorityQueue<QueueItem, DaryHeap<3>>>();
+	checkQueueOrder<MutablePriorityQueue<QueueItem, DaryHeap<4>>>();
+	checkQueueOrder<MutablePriorityQueue<QueueItem, DaryHeap<8>>>();
+	checkQueueOrder<MutablePriorityQueue<QueueItem, PairingHeap>>();
+}
+
+template <class Q>
+long timeDijkstraAndPrim(Graph<pair<int,int>> & g, int n, vector<double> & dists) {
+	dists.clear();
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < n; i += 10) {
+		g.template dijkstraShortestPath<Q>(make_pair(i, n - 1 - i));
+		for (auto v : g.getVertexSet())
+			dists.push_back(v->getDist());
+	}
+	for (auto v : g.template calculatePrim<Q>())
+		dists.push_back(v->getDist());
+	auto finish = std::chrono::high_resolution_clock::now();
+	return chrono::duration_cast<chrono::microseconds>(finish - start).count();
+}
+
+TEST(CAL_FP07, testPerformanceQueuePolicies) {
+	for (int n = 50; n <= 150; n += 50) {
+		Graph<pair<int,int>> g;
+		generateRandomGridGraph(n, g);
+		vector<double> d2, d4, dp;
+		long t2 = timeDijkstraAndPrim<MutablePriorityQueue<Vertex<pair<int,int>>>>(g, n, d2);
+		long t4 = timeDijkstraAndPrim<MutablePriorityQueue<Vertex<pair<int,int>>, DaryHeap<4>>>(g, n, d4);
+		long tp = timeDijkstraAndPrim<MutablePriorityQueue<Vertex<pair<int,int>>, PairingHeap>>(g, n, dp);
+		EXPECT_EQ(d2, d4);
+		EXPECT_EQ(d2, dp);
+		cout << "Grid " << n << " x " << n << " time (micro-seconds): binary=" << t2
+			 << " 4-ary=" << t4 << " pairing=" << tp << endl;
+	}
+}
+
+TEST(CAL_FP07, testBidirectionalDijkstra) {
+	Graph<int> graph = createTestGraph();
+	for (int s = 1; s < 8; s++) {
+		graph.dijkstraShortestPath(s);
+		vector<double> dists;
+		for (int d = 1; d < 8; d++)
+			dists.push_back(graph.findVertex(d)->getDist());
+		for (int d = 1; d < 8; d++) {
+			vector<int> path = graph.shortestPath(s, d);
+			EXPECT_EQ(s, path.front());
+			EXPECT_EQ(d, path.back());
+			EXPECT_EQ(dists[d - 1], graph.findVertex(d)->getDist());
+			EXPECT_EQ(path, graph.getPath(s, d));
+		}
+	}
+	graph.addVertex(8);
+	EXPECT_EQ(vector<int>(), graph.shortestPath(1, 8));
+	graph.addEdge(7, 8, 1);
+	EXPECT_EQ(vector<int>({1, 3, 4, 5, 7, 8}), graph.shortestPath(1, 8));
+}
+
+TEST(CAL_FP07, testPerformanceBidirectionalDijkstra) {
+	int n = 100;
+	Graph<pair<int,int>> g;
+	generateRandomGridGraph(n, g);
+	long tUni = 0, tBi = 0, settledBi = 0;
+	for (int i = 0; i < n; i += 10) {
+		auto s = make_pair(i, 0), t = make_pair(n - 1 - i / 2, n / 2);
+		auto start = std::chrono::high_resolution_clock::now();
+		g.dijkstraShortestPath(s);
+		double d = g.findVertex(t)->getDist();
+		auto mid = std::chrono::high_resolution_clock::now();
+		g.shortestPath(s, t);
+		auto finish = std::chrono::high_resolution_clock::now();
+		EXPECT_EQ(d, g.findVertex(t)->getDist());
+		tUni += chrono::duration_cast<chrono::microseconds>(mid - start).count();
+		tBi += chrono::duration_cast<chrono::microseconds>(finish - mid).count();
+		settledBi += g.getNumSettled();
+	}
+	cout << "Grid " << n << " x " << n << " point-to-point (micro-seconds): dijkstra=" << tUni
+		 << " bidirectional=" << tBi << " (settled " << settledBi / 10 << " of " << n * n << " on average)" << endl;
+}
+
+/**
+ * Map node, as in the TP6 map files (nos.txt: "id;x;y", arestas.txt: "id;n1;n2").
+ */
+struct MapNode {
+	int id;
+	double x, y;
+	bool operator==(const MapNode & n) const { return id == n.id; }
+};
+
+ostream & operator<<(ostream & os, const MapNode & n) {
+	return os << n.id;
+}
+
+/**
+ * Reads a TP6 map as an undirected graph, with edge weights equal to
+ * the euclidean distance between their endpoints.
+ */
+bool readMap(string dir, Graph<MapNode> & g) {
+	ifstream nodeFile(dir + "/nos.txt"), edgeFile(dir + "/arestas.txt");
+	if (!nodeFile || !edgeFile)
+		return false;
+	g.setHasher([](const MapNode & n) { return hash<int>()(n.id); });
+	vector<MapNode> nodes;
+	char sep;
+	MapNode n;
+	while (nodeFile >> n.id >> sep >> n.x >> sep >> n.y) {
+		g.addVertex(n);
+		if ((int) nodes.size() <= n.id)
+			nodes.resize(n.id + 1);
+		nodes[n.id] = n;
+	}
+	int id, n1, n2;
+	while (edgeFile >> id >> sep >> n1 >> sep >> n2)
+		g.addBidirectionalEdge(nodes[n1], nodes[n2], euclideanHeuristic(nodes[n1], nodes[n2]));
+	return true;
+}
+
+TEST(CAL_FP07, testGraphBuilder) {
+	Graph<int> expected = createTestGraph();
+	vector<int> vertices, sources, dests;
+	vector<double> weights;
+	for (auto v : expected.getVertexSet()) {
+		vertices.push_back(v->getInfo());
+		for (auto e : v->getAdj()) {
+			sources.push_back(v->getInfo() - 1);
+			dests.push_back(e.getDest()->getInfo() - 1);
+			weights.push_back(e.getWeight());
+		}
+	}
+	for (int threads = 1; threads <= 3; threads++) {
+		GraphBuilder<int> builder(vertices, sources, dests, weights);
+		builder.setNumThreads(threads);
+		Graph<int> graph;
+		ASSERT_TRUE(builder.build(graph));
+		ASSERT_EQ(7, graph.getNumVertex());
+		for (int i = 0; i < 7; i++) {
+			vector<Edge<int>> a = expected.getVertexSet()[i]->getAdj(), b = graph.getVertexSet()[i]->getAdj();
+			ASSERT_EQ(a.size(), b.size());
+			for (unsigned j = 0; j < a.size(); j++) {
+				EXPECT_EQ(a[j].getDest()->getInfo(), b[j].getDest()->getInfo());
+				EXPECT_EQ(a[j].getWeight(), b[j].getWeight());
+			}
+		}
+		for (int s = 1; s < 8; s++) {
+			expected.dijkstraShortestPath(s);
+			graph.dijkstraShortestPath(s);
+			for (int d = 1; d < 8; d++)
+				EXPECT_EQ(expected.getPath(s, d), graph.getPath(s, d));
+		}
+	}
+
+	// invalid ids are refused, by addEdge and by build
+	GraphBuilder<int> small;
+	small.addVertex(1);
+	small.addVertex(2);
+	EXPECT_TRUE(small.addEdge(0, 1, 1));
+	EXPECT_FALSE(small.addEdge(0, 2, 1));
+	EXPECT_FALSE(small.addBidirectionalEdge(-1, 0, 1));
+	EXPECT_EQ(1, small.getNumEdges());
+	Graph<int> appended = createTestGraph();
+	ASSERT_TRUE(small.build(appended));
+	EXPECT_EQ(9, appended.getNumVertex());
+	EXPECT_EQ(1u, appended.getVertexSet()[7]->getAdj().size());
+	EXPECT_EQ(2, appended.getVertexSet()[7]->getAdj()[0].getDest()->getInfo());
+	Graph<int> unchanged;
+	EXPECT_FALSE(GraphBuilder<int>(vertices, sources, vector<int>(sources.size(), 7), weights).build(unchanged));
+	EXPECT_FALSE(GraphBuilder<int>(vertices, sources, dests, vector<double>()).build(unchanged));
+	EXPECT_EQ(0, unchanged.getNumVertex());
+
+	// repeated contents are refused when the graph has a hasher
+	Graph<int> hashed = createTestGraph();
+	hashed.setHasher([](const int &i) { return (size_t) i; });
+	GraphBuilder<int> repeated;
+	repeated.addVertex(8);
+	repeated.addVertex(8);
+	EXPECT_FALSE(repeated.build(hashed));
+	GraphBuilder<int> existing;
+	existing.addVertex(3);
+	EXPECT_FALSE(existing.build(hashed));
+	EXPECT_EQ(7, hashed.getNumVertex());
+	GraphBuilder<int> fresh;
+	fresh.addVertex(8);
+	EXPECT_TRUE(fresh.build(hashed));
+	EXPECT_NE(nullptr, hashed.findVertex(8));
+
+	// a node id repeated in the map file
+	auto dir = filesystem::temp_directory_path() / "cal_repeated_map";
+	filesystem::create_directories(dir);
+	ofstream(dir / "nos.txt") << "1;0;0\n2;1;0\n1;2;0\n";
+	ofstream(dir / "arestas.txt") << "1;1;2\n";
+	GraphBuilder<int> fromFile;
+	EXPECT_FALSE(fromFile.readMap(dir.string(), [](int id, double, double) { return id; }));
+	filesystem::remove_all(dir);
+
+	Graph<MapNode> map, built;
+	GraphBuilder<MapNode> builder;
+	built.setHasher([](const MapNode & n) { return hash<int>()(n.id); });
+	EXPECT_FALSE(builder.readMap("../TP6/resources/missing", [](int id, double x, double y) { return MapNode{id, x, y}; }));
+	ASSERT_TRUE(readMap("../TP6/resources/mapa1", map));
+	ASSERT_TRUE(builder.readMap("../TP6/resources/mapa1", [](int id, double x, double y) { return MapNode{id, x, y}; }));
+	ASSERT_TRUE(builder.build(built));
+	EXPECT_EQ(map.getNumVertex(), built.getNumVertex());
+	MapNode from = map.getVertexSet().front()->getInfo();
+	map.dijkstraShortestPath(from);
+	built.dijkstraShortestPath(from);
+	for (auto v : map.getVertexSet())
+		EXPECT_NEAR(v->getDist(), built.findVertex(v->getInfo())->getDist(), 1e-9);
+}
+
+TEST(CAL_FP07, testPerformanceGraphBuilder) {
+	int n = 200000, degree = 10;
+	mt19937 gen(n);
+	uniform_int_distribution<int> dis(0, n - 1), weight(1, 100);
+	vector<int> vertices, sources, dests;
+	vector<double> weights;
+	for (int i = 0; i < n; i++)
+		vertices.push_back(i);
+	for (int i = 0; i < n * degree; i++) {
+		sources.push_back(dis(gen));
+		dests.push_back(dis(gen));
+		weights.push_back(weight(gen));
+	}
+
+	Graph<int> expected;
+	auto start = std::chrono::high_resolution_clock::now();
+	expected.setHasher([](const int &i) { return (size_t) i; });
+	for (int v : vertices)
+		expected.addVertex(v);
+	for (unsigned e = 0; e < sources.size(); e++)
+		expected.addEdge(sources[e], dests[e], weights[e]);
+	auto finish = std::chrono::high_resolution_clock::now();
+	cout << "addEdge, " << n << " vertices and " << sources.size() << " edges (ms): "
+		 << chrono::duration_cast<chrono::milliseconds>(finish - start).count() << endl;
+	expected.dijkstraShortestPath(0);
+
+	for (int threads = 1; threads <= 4; threads *= 2) {
+		Graph<int> graph;
+		start = std::chrono::high_resolution_clock::now();
+		GraphBuilder<int> builder(vertices, sources, dests, weights);
+		builder.setNumThreads(threads);
+		graph.setHasher([](const int &i) { return (size_t) i; });
+		builder.build(graph);
+		finish = std::chrono::high_resolution_clock::now();
+		cout << "GraphBuilder with " << threads << " threads (ms): "
+			 << chrono::duration_cast<chrono::milliseconds>(finish - start).count() << endl;
+		graph.dijkstraShortestPath(0);
+		for (int v = 0; v < n; v += 997)
+			EXPECT_EQ(expected.getVertexSet()[v]->getDist(), graph.getVertexSet()[v]->getDist());
+	}
+}
+
+TEST(CAL_FP07, testMappedGraph) {
+	string file = (filesystem::temp_directory_path() / "cal_mapa1.graph").string();
+	EXPECT_FALSE(MappedGraph::convertMap("../TP6/resources/missing", file));
+	ASSERT_TRUE(MappedGraph::convertMap("../TP6/resources/mapa1", file));
+	MappedGraph mapped;
+	ASSERT_TRUE(mapped.open(file));
+
+	Graph<MapNode> built;
+	GraphBuilder<MapNode> builder;
+	builder.readMap("../TP6/resources/mapa1", [](int id, double x, double y) { return MapNode{id, x, y}; });
+	builder.build(built);
+	ASSERT_EQ(built.getNumVertex(), mapped.getNumVertex());
+	FrozenGraph<MapNode> frozen = built.freeze();
+	EXPECT_EQ(frozen.getNumEdges(), mapped.getNumEdges());
+	ASSERT_TRUE(mapped.hasCoords());
+	for (int v = 0; v < mapped.getNumVertex(); v++) {
+		EXPECT_EQ(frozen.getInfo(v).x, mapped.getX(v));
+		EXPECT_EQ(frozen.getInfo(v).y, mapped.getY(v));
+	}
+	SearchContext ctx, expected;
+	for (int s = 0; s < mapped.getNumVertex(); s++) {
+		mapped.dijkstraShortestPath(s, ctx);
+		frozen.dijkstraShortestPath(frozen.getInfo(s), expected);
+		for (int v = 0; v < mapped.getNumVertex(); v++) {
+			EXPECT_EQ(expected.getDist(v), ctx.getDist(v));
+			EXPECT_EQ(expected.getPath(v), ctx.getPath(v));
+		}
+	}
+	mapped.close();
+	EXPECT_FALSE(mapped.isOpen());
+
+	// truncated and foreign files are rejected
+	string bad = (filesystem::temp_directory_path() / "cal_bad.graph").string();
+	ifstream in(file, ios::binary);
+	string contents((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+	ofstream(bad, ios::binary) << contents.substr(0, contents.size() - 8);
+	EXPECT_FALSE(mapped.open(bad));
+	ofstream(bad, ios::binary) << "id;x;y\n0;100;100\n" << string(100, ' ');
+	EXPECT_FALSE(mapped.open(bad));
+	EXPECT_FALSE(mapped.open(bad + ".missing"));
+
+	// and so are files with offsets or targets out of range
+	vector<double> w(2, 1.0), noCoords;
+	ASSERT_TRUE(MappedGraph::write(bad, {0, 1, 2}, {1, 0}, w, noCoords));
+	EXPECT_TRUE(mapped.open(bad));
+	ASSERT_TRUE(MappedGraph::write(bad, {0, 1, 2}, {1, 2}, w, noCoords));
+	EXPECT_FALSE(mapped.open(bad));
+	ASSERT_TRUE(MappedGraph::write(bad, {0, 1, 2}, {-1, 0}, w, noCoords));
+	EXPECT_FALSE(mapped.open(bad));
+	ASSERT_TRUE(MappedGraph::write(bad, {0, 2, 1, 2}, {1, 0}, w, noCoords));
+	EXPECT_FALSE(mapped.open(bad));
+	ASSERT_TRUE(MappedGraph::write(bad, {0, 3, 2}, {1, 0}, w, noCoords));
+	EXPECT_FALSE(mapped.open(bad));
+	filesystem::remove(bad);
+	filesystem::remove(file);
+}
+
+/**
+ * Parses a map the way FichaJUNG (TP6) does, with getline and stoi, as a
+ * baseline for the benchmark below.
+ */
+void parseMapGetline(string dir, vector<int> & nodes, vector<pair<int,int>> & edges) {
+	ifstream nodeFile(dir + "/nos.txt"), edgeFile(dir + "/arestas.txt");
+	string line;
+	while (getline(nodeFile, line, ';')) {
+		nodes.push_back(stoi(line));
+		getline(nodeFile, line, ';');
+		nodes.push_back(stoi(line));
+		getline(nodeFile, line, '\n');
+		nodes.push_back(stoi(line));
+	}
+	while (getline(edgeFile, line, ';')) {
+		getline(edgeFile, line, ';');
+		int n1 = stoi(line);
+		getline(edgeFile, line, '\n');
+		edges.push_back(make_pair(n1, stoi(line)));
+	}
+}
+
+TEST(CAL_FP07, testPerformanceMappedGraph) {
+	// a grid map, in the text format of TP6
+	int n = 400;
+	filesystem::path dir = filesystem::temp_directory_path() / "cal_grid_map";
+	filesystem::create_directories(dir);
+	{
+		ofstream nodeFile(dir / "nos.txt"), edgeFile(dir / "arestas.txt");
+		int id = 0;
+		for (int i = 0; i < n; i++)
+			for (int j = 0; j < n; j++) {
+				nodeFile << i * n + j << ";" << 10 * j << ";" << 10 * i << "\n";
+				if (j + 1 < n)
+					edgeFile << id++ << ";" << i * n + j << ";" << i * n + j + 1 << "\n";
+				if (i + 1 < n)
+					edgeFile << id++ << ";" << i * n + j << ";" << (i + 1) * n + j << "\n";
+			}
+	}
+	string file = (dir / "map.graph").string();
+
+	vector<int> nodes;
+	vector<pair<int,int>> edges;
+	auto start = std::chrono::high_resolution_clock::now();
+	parseMapGetline(dir.string(), nodes, edges);
+	auto finish = std::chrono::high_resolution_clock::now();
+	cout << "getline and stoi, " << n * n << " nodes (ms): "
+		 << chrono::duration_cast<chrono::milliseconds>(finish - start).count() << endl;
+	EXPECT_EQ(3 * n * n, (int) nodes.size());
+
+	Graph<int> built;
+	start = std::chrono::high_resolution_clock::now();
+	GraphBuilder<int> builder;
+	builder.readMap(dir.string(), [](int id, double, double) { return id; });
+	builder.build(built);
+	finish = std::chrono::high_resolution_clock::now();
+	cout << "GraphBuilder::readMap and build (ms): "
+		 << chrono::duration_cast<chrono::milliseconds>(finish - start).count() << endl;
+
+	start = std::chrono::high_resolution_clock::now();
+	ASSERT_TRUE(MappedGraph::convertMap(dir.string(), file));
+	finish = std::chrono::high_resolution_clock::now();
+	cout << "convertMap, once (ms): "
+		 << chrono::duration_cast<chrono::milliseconds>(finish - start).count() << endl;
+
+	MappedGraph mapped;
+	start = std::chrono::high_resolution_clock::now();
+	ASSERT_TRUE(mapped.open(file));
+	finish = std::chrono::high_resolution_clock::now();
+	cout << "MappedGraph::open (us): "
+		 << chrono::duration_cast<chrono::microseconds>(finish - start).count() << endl;
+
+	SearchContext ctx;
+	mapped.dijkstraShortestPath(0, ctx);
+	built.dijkstraShortestPath(0);
+	for (int v = 0; v < n * n; v += 101)
+		EXPECT_EQ(built.getVertexSet()[v]->getDist(), ctx.getDist(v));
+	mapped.close();
+	filesystem::remove_all(dir);
+}
+
+/**
+ * Total weight of a path (INF if some edge is missing).
+ */
+template <class T>
+double pathWeight(Graph<T> & g, const vector<T> & path) {
+	double w = 0;
+	for (unsigned i = 1; i < path.size(); i++) {
+		double best = INF;
+		for (auto e : g.findVertex(path[i-1])->getAdj())
+			if (e.getDest()->getInfo() == path[i])
+				best = min(best, e.getWeight());
+		if (best == INF)
+			return INF;
+		w += best;
+	}
+	return w;
+}
+
+TEST(CAL_FP07, testAStar) {
+	Graph<int> graph = createTestGraph();
+	auto zero = [](const int &, const int &) { return 0.0; };
+	for (int s = 1; s < 8; s++)
+		for (int d = 1; d < 8; d++) {
+			graph.dijkstraShortestPath(s);
+			vector<int> expected = graph.getPath(s, d);
+			EXPECT_EQ(expected, graph.aStarShortestPath(s, d, zero));
+		}
+
+	// fixed seed: the numbers of vertices settled depend on how ties are broken
+	int n = 100;
+	Graph<pair<int,int>> g;
+	generateRandomGridGraph(n, g, 1);
+	long settledDijkstra = 0, settledEuclidean = 0, settledManhattan = 0;
+	for (int i = 0; i < n; i += 10) {
+		auto s = make_pair(i, 0), t = make_pair(n - 1 - i / 2, n / 2);
+		g.dijkstraShortestPath(s);
+		double d = g.findVertex(t)->getDist();
+		g.aStarShortestPath(s, t, [](const pair<int,int> &, const pair<int,int> &) { return 0.0; });
+		settledDijkstra += g.getNumSettled();
+		g.aStarShortestPath(s, t, euclideanHeuristic<pair<int,int>>);
+		EXPECT_EQ(d, g.findVertex(t)->getDist());
+		settledEuclidean += g.getNumSettled();
+		g.aStarShortestPath(s, t, manhattanHeuristic<pair<int,int>>);
+		EXPECT_EQ(d, g.findVertex(t)->getDist());
+		settledManhattan += g.getNumSettled();
+	}
+	EXPECT_LE(settledManhattan, settledEuclidean);
+	EXPECT_LE(settledEuclidean, settledDijkstra);
+	cout << "Grid " << n << " x " << n << " vertices settled: dijkstra=" << settledDijkstra
+		 << " A* euclidean=" << settledEuclidean << " A* manhattan=" << settledManhattan << endl;
+
+	Graph<MapNode> map;
+	ASSERT_TRUE(readMap("../TP6/resources/mapa1", map));
+	MapNode from = map.getVertexSet().front()->getInfo(), to = map.getVertexSet().back()->getInfo();
+	map.dijkstraShortestPath(from);
+	vector<MapNode> expected = map.getPath(from, to);
+	double d = map.findVertex(to)->getDist();
+	map.aStarShortestPath(from, to, euclideanHeuristic<MapNode>);
+	EXPECT_NEAR(d, map.findVertex(to)->getDist(), 1e-9);
+	vector<MapNode> path = map.getPath(from, to);
+	EXPECT_EQ(expected.empty(), path.empty());
+	if (!path.empty()) {
+		EXPECT_EQ(expected.front(), path.front());
+		EXPECT_EQ(expected.back(), path.back());
+		EXPECT_NEAR(pathWeight(map, expected), pathWeight(map, path), 1e-9);
+	}
+
+	// edges in any direction, weighted by the Euclidean distance: the Manhattan
+	// distance may overestimate it (by up to sqrt(2)), so A* may return longer paths
+	int longer = 0, pairs = 0;
+	for (auto s : map.getVertexSet())
+		for (auto t : map.getVertexSet()) {
+			map.dijkstraShortestPath(s->getInfo());
+			d = t->getDist();
+			if (d == INF)
+				continue;
+			map.aStarShortestPath(s->getInfo(), t->getInfo(), manhattanHeuristic<MapNode>);
+			EXPECT_GE(t->getDist(), d - 1e-9);
+			if (t->getDist() > d + 1e-9)
+				longer++;
+			pairs++;
+		}
+	cout << "mapa1, A* manhattan, paths longer than the shortest: " << longer << " of " << pairs << endl;
+
+	// a diagonal shortcut that Manhattan overestimates: the path along the axis is taken
+	Graph<MapNode> diag;
+	MapNode s{0, 0, 0}, a{1, 5, 5}, c{2, 5, 0}, t{3, 10, 0};
+	for (auto &v : {s, a, c, t})
+		diag.addVertex(v);
+	diag.addEdge(s, a, hypot(5, 5));
+	diag.addEdge(a, t, hypot(5, 5));
+	diag.addEdge(s, c, 7.5);
+	diag.addEdge(c, t, 7.5);
+	EXPECT_EQ(vector<MapNode>({s, a, t}), diag.aStarShortestPath(s, t, euclideanHeuristic<MapNode>));
+	EXPECT_EQ(vector<MapNode>({s, c, t}), diag.aStarShortestPath(s, t, manhattanHeuristic<MapNode>));
+	EXPECT_EQ(15, diag.findVertex(t)->getDist());
+}
+
+TEST(CAL_FP07, testContractionHierarchy) {
+	Graph<int> graph = createTestGraph();
+	graph.addVertex(8);
+	graph.addEdge(7, 8, 1);
+	ContractionHierarchy<int> ch(graph);
+	for (int s = 1; s < 9; s++) {
+		graph.dijkstraShortestPath(s);
+		for (int d = 1; d < 9; d++) {
+			vector<int> path = ch.shortestPath(s, d);
+			EXPECT_EQ(graph.getPath(s, d).size() > 0, path.size() > 0);
+			EXPECT_EQ(graph.findVertex(d)->getDist(), ch.distance(s, d));
+			if (path.size() > 0) {
+				EXPECT_EQ(s, path.front());
+				EXPECT_EQ(d, path.back());
+				EXPECT_EQ(graph.findVertex(d)->getDist(), pathWeight(graph, path));
+			}
+		}
+	}
+
+	Graph<MapNode> map;
+	ASSERT_TRUE(readMap("../TP6/resources/mapa1", map));
+	ContractionHierarchy<MapNode> mapCH(map);
+	for (auto s : map.getVertexSet()) {
+		map.dijkstraShortestPath(s->getInfo());
+		for (auto d : map.getVertexSet()) {
+			EXPECT_NEAR(d->getDist(), mapCH.distance(s->getInfo(), d->getInfo()), 1e-9);
+			vector<MapNode> path = mapCH.shortestPath(s->getInfo(), d->getInfo());
+			if (d->getDist() != INF) {
+				EXPECT_EQ(s->getInfo(), path.front());
+				EXPECT_EQ(d->getInfo(), path.back());
+				EXPECT_NEAR(d->getDist(), pathWeight(map, path), 1e-9);
+			}
+		}
+	}
+}
+
+TEST(CAL_FP07, testPerformanceContractionHierarchy) {
+	for (int n = 50; n <= 150; n += 50) {
+		Graph<pair<int,int>> g;
+		generateRandomGridGraph(n, g);
+		auto start = std::chrono::high_resolution_clock::now();
+		ContractionHierarchy<pair<int,int>> ch(g);
+		auto finish = std::chrono::high_resolution_clock::now();
+		long tBuild = chrono::duration_cast<chrono::milliseconds>(finish - start).count();
+
+		std::mt19937 gen(n);
+		std::uniform_int_distribution<int> dis(0, n - 1);
+		long tDijkstra = 0, tCH = 0, settled = 0;
+		int queries = 20;
+		for (int i = 0; i < queries; i++) {
+			auto s = make_pair(dis(gen), dis(gen)), t = make_pair(dis(gen), dis(gen));
+			start = std::chrono::high_resolution_clock::now();
+			g.dijkstraShortestPath(s);
+			vector<pair<int,int>> expected = g.getPath(s, t);
+			auto mid = std::chrono::high_resolution_clock::now();
+			vector<pair<int,int>> path = ch.shortestPath(s, t);
+			finish = std::chrono::high_resolution_clock::now();
+			EXPECT_EQ(g.findVertex(t)->getDist(), ch.distance(s, t));
+			EXPECT_EQ(g.findVertex(t)->getDist(), pathWeight(g, path));
+			EXPECT_EQ(expected.front(), path.front());
+			EXPECT_EQ(expected.back(), path.back());
+			tDijkstra += chrono::duration_cast<chrono::microseconds>(mid - start).count();
+			tCH += chrono::duration_cast<chrono::microseconds>(finish - mid).count();
+			settled += ch.getNumSettled();
+		}
+		cout << "Grid " << n << " x " << n << ": CH built in " << tBuild << " ms with " << ch.getNumShortcuts()
+			 << " shortcuts; average query (micro-seconds): dijkstra=" << tDijkstra / queries << " CH=" << tCH / queries
+			 << " (settled " << settled / queries << ")" << endl;
+	}
+}
+
+TEST(CAL_FP07, testFloydWarshall) {
+	Graph<int> graph = createTestGraph();
+	graph.addVertex(8);
+	graph.addEdge(7, 8, 1);
+	graph.floydWarshallShortestPath();
+	EXPECT_EQ(vector<int>({1, 3, 4, 5, 7, 8}), graph.getfloydWarshallPath(1, 8));
+	EXPECT_EQ(vector<int>(), graph.getfloydWarshallPath(8, 1));
+	for (int s = 1; s < 9; s++) {
+		graph.dijkstraShortestPath(s);
+		for (int d = 1; d < 9; d++) {
+			vector<int> path = graph.getfloydWarshallPath(s, d);
+			if (graph.findVertex(d)->getDist() == INF) {
+				EXPECT_EQ(0, path.size());
+			}
+			else {
+				EXPECT_EQ(graph.findVertex(d)->getDist(), pathWeight(graph, path));
+			}
+		}
+	}
+}
+
+TEST(CAL_FP07, testPerformanceFloydWarshall) {
+	int n = 30;
+	Graph<pair<int,int>> g;
+	generateRandomGridGraph(n, g);
+	vector<vector<pair<int,int>>> paths;
+	for (int threads = 1; threads <= 4; threads *= 2) {
+		g.setNumThreads(threads);
+		auto start = std::chrono::high_resolution_clock::now();
+		g.floydWarshallShortestPath();
+		auto finish = std::chrono::high_resolution_clock::now();
+		cout << "Floyd-Warshall grid " << n << " x " << n << " with " << threads << " threads (ms): "
+			 << chrono::duration_cast<chrono::milliseconds>(finish - start).count() << endl;
+		vector<vector<pair<int,int>>> res;
+		for (int i = 0; i < n; i += 3) {
+			auto s = make_pair(i, 0), t = make_pair(n - 1 - i, n - 1);
+			res.push_back(g.getfloydWarshallPath(s, t));
+			g.dijkstraShortestPath(s);
+			EXPECT_EQ(g.findVertex(t)->getDist(), pathWeight(g, res.back()));
+		}
+		if (threads > 1) {
+			EXPECT_EQ(paths, res);
+		}
+		paths = res;
+	}
+}
+
+TEST(CAL_FP07, testJohnson) {
+	Graph<int> graph = createTestGraph();
+	graph.addVertex(8);
+	graph.addEdge(7, 8, 1);
+	EXPECT_TRUE(graph.johnsonAllPairs());
+	EXPECT_EQ(vector<int>({1, 3, 4, 5, 7, 8}), graph.getfloydWarshallPath(1, 8));
+	EXPECT_EQ(vector<int>(), graph.getfloydWarshallPath(8, 1));
+
+	// negative edges, without negative cycles
+	Graph<int> dag;
+	for (int i = 1; i <= 5; i++)
+		dag.addVertex(i);
+	dag.addEdge(1, 2, 4);
+	dag.addEdge(1, 3, 2);
+	dag.addEdge(3, 2, -3);
+	dag.addEdge(2, 4, 2);
+	dag.addEdge(3, 4, 1);
+	dag.addEdge(4, 5, -1);
+	dag.floydWarshallShortestPath();
+	vector<vector<int>> expected;
+	for (int s = 1; s <= 5; s++)
+		for (int d = 1; d <= 5; d++)
+			expected.push_back(dag.getfloydWarshallPath(s, d));
+	EXPECT_TRUE(dag.johnsonAllPairs());
+	for (int s = 1; s <= 5; s++)
+		for (int d = 1; d <= 5; d++)
+			EXPECT_EQ(expected[(s - 1) * 5 + d - 1], dag.getfloydWarshallPath(s, d));
+	EXPECT_EQ(vector<int>({1, 3, 2, 4, 5}), dag.getfloydWarshallPath(1, 5));
+
+	dag.addEdge(5, 3, -2);
+	EXPECT_FALSE(dag.johnsonAllPairs());
+	EXPECT_EQ(vector<int>(), dag.getfloydWarshallPath(1, 5));
+}
+
+TEST(CAL_FP07, testPerformanceJohnson) {
+	int n = 30;
+	Graph<pair<int,int>> g;
+	generateRandomGridGraph(n, g);
+	auto start = std::chrono::high_resolution_clock::now();
+	g.floydWarshallShortestPath();
+	auto finish = std::chrono::high_resolution_clock::now();
+	cout << "Floyd-Warshall grid " << n << " x " << n << " (ms): "
+		 << chrono::duration_cast<chrono::milliseconds>(finish - start).count() << endl;
+	vector<double> expected;
+	for (int i = 0; i < n; i += 3)
+		expected.push_back(pathWeight(g, g.getfloydWarshallPath(make_pair(i, 0), make_pair(n - 1 - i, n - 1))));
+	for (int threads = 1; threads <= 4; threads *= 2) {
+		g.setNumThreads(threads);
+		start = std::chrono::high_resolution_clock::now();
+		EXPECT_TRUE(g.johnsonAllPairs());
+		finish = std::chrono::high_resolution_clock::now();
+		cout << "Johnson grid " << n << " x " << n << " with " << threads << " threads (ms): "
+			 << chrono::duration_cast<chrono::milliseconds>(finish - start).count() << endl;
+		for (int i = 0; i < n; i += 3)
+			EXPECT_EQ(expected[i / 3], pathWeight(g, g.getfloydWarshallPath(make_pair(i, 0), make_pair(n - 1 - i, n - 1))));
+	}
+}
+
+TEST(CAL_FP07, testBellmanFord) {
+	Graph<int> graph = createTestGraph();
+	for (int s = 1; s < 8; s++) {
+		graph.dijkstraShortestPath(s);
+		vector<double> expected;
+		for (auto v : graph.getVertexSet())
+			expected.push_back(v->getDist());
+		for (int threads = 1; threads <= 3; threads++)
+			for (bool queue : {false, true}) {
+				graph.setNumThreads(threads);
+				EXPECT_TRUE(graph.bellmanFordShortestPath(s, queue));
+				EXPECT_EQ(vector<int>(), graph.getNegativeCycle());
+				for (unsigned i = 0; i < expected.size(); i++)
+					EXPECT_EQ(expected[i], graph.getVertexSet()[i]->getDist());
+			}
+	}
+
+	// negative edges, without and with a negative cycle
+	Graph<int> dag;
+	for (int i = 1; i <= 6; i++)
+		dag.addVertex(i);
+	dag.addEdge(1, 2, 4);
+	dag.addEdge(1, 3, 2);
+	dag.addEdge(3, 2, -3);
+	dag.addEdge(2, 4, 2);
+	dag.addEdge(3, 4, 1);
+	dag.addEdge(4, 5, -1);
+	dag.addEdge(1, 6, 1);
+	for (int threads = 1; threads <= 3; threads++)
+		for (bool queue : {false, true}) {
+			dag.setNumThreads(threads);
+			EXPECT_TRUE(dag.bellmanFordShortestPath(1, queue));
+			EXPECT_EQ(vector<int>({1, 3, 2, 4, 5}), dag.getPath(1, 5));
+			EXPECT_EQ(0, dag.getVertexSet()[4]->getDist());
+		}
+	dag.addEdge(5, 3, -2);
+	for (int threads = 1; threads <= 3; threads++)
+		for (bool queue : {false, true}) {
+			dag.setNumThreads(threads);
+			EXPECT_FALSE(dag.bellmanFordShortestPath(1, queue));
+			vector<int> cycle = dag.getNegativeCycle();
+			ASSERT_EQ(4u, cycle.size());
+			rotate(cycle.begin(), find(cycle.begin(), cycle.end(), 3), cycle.end());
+			EXPECT_EQ(vector<int>({3, 2, 4, 5}), cycle);
+		}
+	// not reachable from the source
+	EXPECT_TRUE(dag.bellmanFordShortestPath(6));
+	EXPECT_TRUE(dag.getNegativeCycle().empty());
+}
+
+TEST(CAL_FP07, testDeltaStepping) {
+	Graph<int> graph = createTestGraph();
+	for (int s = 1; s < 8; s++) {
+		graph.dijkstraShortestPath(s);
+		vector<double> expected;
+		for (auto v : graph.getVertexSet())
+			expected.push_back(v->getDist());
+		for (double delta : {0.5, 1.0, 3.0, 100.0})
+			for (int threads = 1; threads <= 3; threads++) {
+				graph.setNumThreads(threads);
+				graph.deltaSteppingShortestPath(s, delta);
+				for (unsigned i = 0; i < expected.size(); i++)
+					EXPECT_EQ(expected[i], graph.getVertexSet()[i]->getDist());
+				for (int d = 1; d < 8; d++)
+					EXPECT_EQ(graph.getVertexSet()[d - 1]->getDist(), pathWeight(graph, graph.getPath(s, d)));
+			}
+	}
+	graph.addVertex(8);
+	graph.deltaSteppingShortestPath(1, 2);
+	EXPECT_EQ(vector<int>(), graph.getPath(1, 8));
+}
+
+TEST(CAL_FP07, testPerformanceDeltaStepping) {
+	int n = 300;
+	Graph<pair<int,int>> g;
+	generateRandomGridGraph(n, g);
+	const FrozenGraph<pair<int,int>> frozen = g.freeze();
+	SearchContext expected, ctx;
+	auto start = std::chrono::high_resolution_clock::now();
+	frozen.dijkstraShortestPath(make_pair(0, 0), expected);
+	auto finish = std::chrono::high_resolution_clock::now();
+	cout << "Dijkstra grid " << n << " x " << n << " (ms): "
+		 << chrono::duration_cast<chrono::milliseconds>(finish - start).count() << endl;
+	for (int threads = 1; threads <= 8; threads *= 2) {
+		start = std::chrono::high_resolution_clock::now();
+		frozen.deltaSteppingShortestPath(make_pair(0, 0), n / 4, threads, ctx);
+		finish = std::chrono::high_resolution_clock::now();
+		cout << "Delta-stepping grid " << n << " x " << n << " with " << threads << " threads (ms): "
+			 << chrono::duration_cast<chrono::milliseconds>(finish - start).count() << endl;
+		for (int v = 0; v < frozen.getNumVertex(); v++)
+			EXPECT_EQ(expected.getDist(v), ctx.getDist(v));
+	}
+}
+
 TEST(CAL_FP07, testPrim) {
 	Graph<int> graph = createTestGraph();
 	vector<Vertex<int>* > res = graph.calculatePrim();
@@ -7,6 +7,8 @@
 #include <vector>
 #include <queue>
 #include <limits>
+#include <unordered_map>
+#include <functional>
 #include <cmath>
 
 using namespace std;
@@ -103,8 +105,11 @@ Vertex<T>* Edge<T>::getDest() const {
 template <class T>
 class Graph {
 	vector<Vertex<T> *> vertexSet;
+	unordered_map<T, Vertex<T> *, function<size_t(const T &)>> vertexIndex; // optional, see setHasher
+	bool indexed = false;
 	Vertex<T>* findVertex(const T &inf) const;
 public:
+	void setHasher(function<size_t(const T &)> hasher);
 	vector<Vertex<T> *> getVertexSet() const;
 	Vertex<T> *addVertex(const T &in);
 	Edge<T> *addEdge(const T &sourc, const T &dest, double c, double f=0);
@@ -124,6 +129,8 @@ Vertex<T> * Graph<T>::addVertex(const T &in) {
 		return v;
 	v = new Vertex<T>(in);
 	vertexSet.push_back(v);
+	if (indexed)
+		vertexIndex.emplace(in, v);
 	return v;
 }
 
@@ -137,8 +144,25 @@ Edge<T> * Graph<T>::addEdge(const T &sourc, const T &dest, double c, double f) {
 		return s->addEdge(d, c, f);
 }
 
+/*
+ * Enables a hash index over the vertex contents, using the given hash function,
+ * so that findVertex runs in constant expected time instead of scanning vertexSet.
+ * Vertices already in the graph are indexed immediately.
+ */
+template <class T>
+void Graph<T>::setHasher(function<size_t(const T &)> hasher) {
+	vertexIndex = unordered_map<T, Vertex<T> *, function<size_t(const T &)>>(vertexSet.size(), hasher);
+	for (auto v : vertexSet)
+		vertexIndex.emplace(v->info, v);
+	indexed = true;
+}
+
 template <class T>
 Vertex<T>* Graph<T>::findVertex(const T & inf) const {
+	if (indexed) {
+		auto it = vertexIndex.find(inf);
+		return it == vertexIndex.end() ? nullptr : it->second;
+	}
 	for (auto v : vertexSet)
 		if (v->info == inf)
 			return v;